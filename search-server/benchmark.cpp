@@ -0,0 +1,797 @@
+#include "search_server.h"
+#include "inverted_index.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "string_hash_map.h"
+#include "string_processing.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define HAS_GETRUSAGE 1
+#endif
+
+using namespace std;
+
+// Замеры производительности сервера на синтетическом корпусе: слова документов и запросов
+// и длины запросов распределены по закону Ципфа. Каждый этап выводится строкой JSON:
+// количество замеренных операций, обработанных элементов (документов, запросов
+// или пар документ-частота), время, пропускная способность, p50/p99 длительности операции,
+// пиковая память процесса и дополнительные поля этапа.
+// При одинаковых параметрах корпус и запросы одинаковы на любой платформе
+
+// Параметры запуска, задаются в командной строке как --имя значение
+struct BenchmarkOptions {
+    size_t documents = 10'000;
+    size_t queries = 10'000;
+    size_t vocabulary = 50'000;
+    // Показатель степени закона Ципфа для слов и длин запросов
+    double zipf = 1.0;
+    size_t min_document_words = 20;
+    size_t max_document_words = 200;
+    size_t max_query_words = 8;
+    // Самые частые слова словаря становятся стоп-словами
+    size_t stop_words = 20;
+    // Доля запросов с минус-словом
+    double minus_words = 0.1;
+    // Доля документов, повторяющих слова другого документа пакета
+    double duplicates = 0.01;
+    // Документов в пакете AddDocuments и запросов в пакете ProcessQueries
+    size_t batch = 10'000;
+    // Документов, удаляемых в каждом из этапов удаления
+    size_t removals = 1'000;
+    // Потоков пула сервера, 0 - по количеству ядер
+    size_t threads = 0;
+    uint64_t seed = 42;
+    // Способ отбора лучших документов в последовательном поиске
+    QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE;
+    // Способ накопления релевантности в параллельном поиске
+    ParallelAccumulation accumulation = ParallelAccumulation::PARTIAL_TABLES;
+    // Формат списков документов сервера
+    PostingsFormat postings_format = PostingsFormat::RAW;
+};
+
+const vector<pair<string_view, QueryEvaluation>> QUERY_EVALUATION_NAMES = {
+    {"exhaustive"sv, QueryEvaluation::EXHAUSTIVE}, {"max_score"sv, QueryEvaluation::MAX_SCORE} };
+
+const vector<pair<string_view, ParallelAccumulation>> PARALLEL_ACCUMULATION_NAMES = {
+    {"concurrent_map"sv, ParallelAccumulation::CONCURRENT_MAP},
+    {"partial_tables"sv, ParallelAccumulation::PARTIAL_TABLES},
+    {"document_ranges"sv, ParallelAccumulation::DOCUMENT_RANGES} };
+
+const vector<pair<string_view, PostingsFormat>> POSTINGS_FORMAT_NAMES = {
+    {"raw"sv, PostingsFormat::RAW}, {"compressed"sv, PostingsFormat::COMPRESSED} };
+
+// Значение перечисления по имени из списка names
+template <typename Enum>
+Enum ParseEnumOption(string_view option, istringstream& value, const vector<pair<string_view, Enum>>& names) {
+    string text;
+    value >> text;
+    for (const auto& [name, item] : names) {
+        if (name == text) {
+            return item;
+        }
+    }
+    throw invalid_argument("Invalid value for option "s + string(option));
+}
+
+template <typename Enum>
+string_view GetEnumName(Enum item, const vector<pair<string_view, Enum>>& names) {
+    for (const auto& [name, name_item] : names) {
+        if (name_item == item) {
+            return name;
+        }
+    }
+    return ""sv;
+}
+
+BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    const vector<pair<string_view, size_t*>> size_options = {
+        {"--documents"sv, &options.documents}, {"--queries"sv, &options.queries},
+        {"--vocabulary"sv, &options.vocabulary}, {"--min-document-words"sv, &options.min_document_words},
+        {"--max-document-words"sv, &options.max_document_words}, {"--max-query-words"sv, &options.max_query_words},
+        {"--stop-words"sv, &options.stop_words}, {"--batch"sv, &options.batch},
+        {"--removals"sv, &options.removals}, {"--threads"sv, &options.threads} };
+    const vector<pair<string_view, double*>> double_options = {
+        {"--zipf"sv, &options.zipf}, {"--minus-words"sv, &options.minus_words},
+        {"--duplicates"sv, &options.duplicates} };
+
+    for (int i = 1; i < argc; i += 2) {
+        const string_view name = argv[i];
+        if (i + 1 == argc) {
+            throw invalid_argument("No value for option "s + string(name));
+        }
+        istringstream value(argv[i + 1]);
+        bool is_known = false;
+        for (const auto& [option, field] : size_options) {
+            if (option == name) {
+                value >> *field;
+                is_known = true;
+            }
+        }
+        for (const auto& [option, field] : double_options) {
+            if (option == name) {
+                value >> *field;
+                is_known = true;
+            }
+        }
+        if (name == "--seed"sv) {
+            value >> options.seed;
+            is_known = true;
+        }
+        if (name == "--evaluation"sv) {
+            options.evaluation = ParseEnumOption(name, value, QUERY_EVALUATION_NAMES);
+            is_known = true;
+        }
+        if (name == "--accumulation"sv) {
+            options.accumulation = ParseEnumOption(name, value, PARALLEL_ACCUMULATION_NAMES);
+            is_known = true;
+        }
+        if (name == "--postings-format"sv) {
+            options.postings_format = ParseEnumOption(name, value, POSTINGS_FORMAT_NAMES);
+            is_known = true;
+        }
+        if (!is_known) {
+            throw invalid_argument("Unknown option "s + string(name));
+        }
+        if (!value || !value.eof()) {
+            throw invalid_argument("Invalid value for option "s + string(name));
+        }
+    }
+    if (options.vocabulary <= options.stop_words || options.min_document_words == 0
+        || options.min_document_words > options.max_document_words || options.max_query_words == 0
+        || options.batch == 0 || options.zipf <= 0.0) {
+        throw invalid_argument("Inconsistent options"s);
+    }
+    return options;
+}
+
+// Случайные числа без std-распределений: их результаты зависят от стандартной библиотеки,
+// а последовательность mt19937_64 задана стандартом
+class BenchmarkRandom {
+public:
+    explicit BenchmarkRandom(uint64_t seed)
+        : engine_(seed) {
+    }
+
+    // Равномерно в [0, 1)
+    double Uniform() {
+        return static_cast<double>(engine_() >> 11) * 0x1.0p-53;
+    }
+
+    // Равномерно в [0, count)
+    size_t Below(size_t count) {
+        return static_cast<size_t>(Uniform() * count);
+    }
+
+private:
+    mt19937_64 engine_;
+};
+
+// Номера от 0 до count - 1 с вероятностями, пропорциональными 1 / (номер + 1)^exponent
+class ZipfDistribution {
+public:
+    ZipfDistribution(size_t count, double exponent) {
+        cumulative_weights_.reserve(count);
+        double total = 0.0;
+        for (size_t rank = 1; rank <= count; ++rank) {
+            total += 1.0 / pow(static_cast<double>(rank), exponent);
+            cumulative_weights_.push_back(total);
+        }
+    }
+
+    size_t operator()(BenchmarkRandom& random) const {
+        const double weight = random.Uniform() * cumulative_weights_.back();
+        const auto it = upper_bound(cumulative_weights_.begin(), cumulative_weights_.end(), weight);
+        return min<size_t>(it - cumulative_weights_.begin(), cumulative_weights_.size() - 1);
+    }
+
+private:
+    vector<double> cumulative_weights_;
+};
+
+// Слово словаря по рангу частоты: "a", "b", ..., "z", "aa", ... - частые слова короче редких
+string MakeWord(size_t rank) {
+    string word;
+    for (++rank; rank > 0; rank = (rank - 1) / 26) {
+        word += static_cast<char>('a' + (rank - 1) % 26);
+    }
+    return word;
+}
+
+// Синтетический корпус: документы генерируются пакетами и не хранятся целиком,
+// поэтому память генератора не зависит от количества документов
+class Corpus {
+public:
+    explicit Corpus(const BenchmarkOptions& options)
+        : options_(options)
+        , random_(options.seed)
+        , words_(options.vocabulary, options.zipf)
+        , query_lengths_(options.max_query_words, options.zipf) {
+        vocabulary_.reserve(options.vocabulary);
+        for (size_t rank = 0; rank < options.vocabulary; ++rank) {
+            vocabulary_.push_back(MakeWord(rank));
+        }
+    }
+
+    string GetStopWords() const {
+        string stop_words;
+        for (size_t rank = 0; rank < options_.stop_words; ++rank) {
+            stop_words += vocabulary_[rank];
+            stop_words += ' ';
+        }
+        return stop_words;
+    }
+
+    // Тексты пакета документов с id от first_id; NewDocument ссылаются на texts
+    void GenerateBatch(int first_id, size_t count, vector<string>& texts, vector<NewDocument>& documents) {
+        texts.assign(count, string());
+        documents.clear();
+        vector<string_view> words;
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0 && random_.Uniform() < options_.duplicates) {
+                // Те же слова, что у документа пакета, в другом порядке
+                words = SplitIntoWordsView(texts[random_.Below(i)]);
+                for (size_t j = words.size(); j > 1; --j) {
+                    swap(words[j - 1], words[random_.Below(j)]);
+                }
+                for (string_view word : words) {
+                    texts[i] += word;
+                    texts[i] += ' ';
+                }
+            }
+            else {
+                const size_t word_count = options_.min_document_words
+                    + random_.Below(options_.max_document_words - options_.min_document_words + 1);
+                for (size_t j = 0; j < word_count; ++j) {
+                    texts[i] += vocabulary_[words_(random_)];
+                    texts[i] += ' ';
+                }
+            }
+            // Большинство документов актуальны, рейтинги от -10 до 10
+            const double status_choice = random_.Uniform();
+            const DocumentStatus status = status_choice < 0.9 ? DocumentStatus::ACTUAL
+                : status_choice < 0.95 ? DocumentStatus::IRRELEVANT
+                : status_choice < 0.98 ? DocumentStatus::BANNED : DocumentStatus::REMOVED;
+            vector<int> ratings(1 + random_.Below(3));
+            for (int& rating : ratings) {
+                rating = static_cast<int>(random_.Below(21)) - 10;
+            }
+            documents.push_back({ first_id + static_cast<int>(i), texts[i], status, move(ratings) });
+        }
+    }
+
+    vector<string> GenerateQueries(size_t count) {
+        vector<string> queries(count);
+        for (string& query : queries) {
+            const size_t word_count = 1 + query_lengths_(random_);
+            for (size_t j = 0; j < word_count; ++j) {
+                query += vocabulary_[words_(random_)];
+                query += ' ';
+            }
+            if (random_.Uniform() < options_.minus_words) {
+                query += '-';
+                query += vocabulary_[words_(random_)];
+            }
+        }
+        return queries;
+    }
+
+    BenchmarkRandom& GetRandom() {
+        return random_;
+    }
+
+private:
+    const BenchmarkOptions& options_;
+    BenchmarkRandom random_;
+    vector<string> vocabulary_;
+    ZipfDistribution words_;
+    ZipfDistribution query_lengths_;
+};
+
+// Пиковая резидентная память процесса в килобайтах, -1 - если недоступна
+long GetPeakRssKb() {
+#ifdef HAS_GETRUSAGE
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#ifdef __APPLE__
+    return static_cast<long>(usage.ru_maxrss / 1024);
+#else
+    return static_cast<long>(usage.ru_maxrss);
+#endif
+#else
+    return -1;
+#endif
+}
+
+// Длительности операций одного этапа
+class StageTimer {
+public:
+    using Clock = chrono::steady_clock;
+
+    explicit StageTimer(string name)
+        : name_(move(name)) {
+        SearchServer::ResetStats();
+    }
+
+    // Дополнительное поле строки этапа, например память на элемент
+    void AddMetric(string name, double value) {
+        metrics_.emplace_back(move(name), value);
+    }
+
+    // Замеряет operation(), обработавшую item_count элементов
+    template <typename Operation>
+    void Measure(size_t item_count, Operation operation) {
+        const auto start = Clock::now();
+        operation();
+        durations_.push_back(Clock::now() - start);
+        item_count_ += item_count;
+    }
+
+    // Строка JSON с результатами этапа
+    void Report(ostream& out) const {
+        vector<Clock::duration> durations = durations_;
+        sort(durations.begin(), durations.end());
+        Clock::duration total{};
+        for (const auto duration : durations) {
+            total += duration;
+        }
+        const double seconds = chrono::duration<double>(total).count();
+        // Перцентиль по ближайшему рангу
+        const auto percentile_us = [&durations](double percentile) {
+            if (durations.empty()) {
+                return 0.0;
+            }
+            const size_t rank = static_cast<size_t>(ceil(percentile * durations.size()));
+            return chrono::duration<double, micro>(durations[max<size_t>(rank, 1) - 1]).count();
+        };
+        out << fixed << setprecision(3)
+            << "{\"stage\":\""s << name_ << "\",\"operations\":"s << durations.size()
+            << ",\"items\":"s << item_count_ << ",\"seconds\":"s << seconds
+            << ",\"items_per_second\":"s << (seconds > 0.0 ? item_count_ / seconds : 0.0)
+            << ",\"p50_us\":"s << percentile_us(0.5) << ",\"p99_us\":"s << percentile_us(0.99)
+            << ",\"peak_rss_kb\":"s << GetPeakRssKb();
+        for (const auto& [name, value] : metrics_) {
+            out << ",\""s << name << "\":"s << value;
+        }
+        if (SearchStats::IS_ENABLED) {
+            ReportSearchStats(out);
+        }
+        out << '}' << endl;
+    }
+
+private:
+    string name_;
+    vector<Clock::duration> durations_;
+    vector<pair<string, double>> metrics_;
+
+    // Этапы поиска, выполнявшиеся в замере, и счетчики
+    static void ReportSearchStats(ostream& out) {
+        const SearchStatsSnapshot stats = SearchServer::GetStatsSnapshot();
+        out << ",\"search_stages\":{"s;
+        bool is_first = true;
+        for (size_t i = 0; i < SEARCH_STAGE_COUNT; ++i) {
+            const SearchStage stage = static_cast<SearchStage>(i);
+            const LatencyHistogram& histogram = stats.GetStage(stage);
+            if (histogram.GetCount() == 0) {
+                continue;
+            }
+            out << (is_first ? ""s : ","s) << '"' << GetSearchStageName(stage) << "\":{\"count\":"s
+                << histogram.GetCount() << ",\"mean_ns\":"s << histogram.GetMeanNanoseconds()
+                << ",\"p50_ns\":"s << histogram.GetPercentileNanoseconds(0.5)
+                << ",\"p99_ns\":"s << histogram.GetPercentileNanoseconds(0.99) << '}';
+            is_first = false;
+        }
+        out << "},\"search_counters\":{"s;
+        for (size_t i = 0; i < SEARCH_COUNTER_COUNT; ++i) {
+            const SearchCounter counter = static_cast<SearchCounter>(i);
+            out << (i == 0 ? ""s : ","s) << '"' << GetSearchCounterName(counter) << "\":"s << stats.GetCounter(counter);
+        }
+        out << '}';
+    }
+    size_t item_count_ = 0;
+};
+
+// Тексты всех документов корпуса: те же, что добавляются в сервер при тех же параметрах
+vector<string> GenerateDocumentTexts(const BenchmarkOptions& options) {
+    Corpus corpus(options);
+    vector<string> all_texts;
+    all_texts.reserve(options.documents);
+    vector<string> texts;
+    vector<NewDocument> documents;
+    for (size_t first = 0; first < options.documents; first += options.batch) {
+        corpus.GenerateBatch(static_cast<int>(first), min(options.batch, options.documents - first), texts, documents);
+        move(texts.begin(), texts.end(), back_inserter(all_texts));
+    }
+    return all_texts;
+}
+
+// Частоты слов документа без отсева стоп-слов, по алфавиту
+map<string_view, double> ComputeWordFreqs(string_view text) {
+    map<string_view, double> word_freqs;
+    const vector<string_view> words = SplitIntoWordsView(text);
+    for (string_view word : words) {
+        word_freqs[word] += 1.0 / words.size();
+    }
+    return word_freqs;
+}
+
+// Обход списков документов слов запросов: исходный индекс на деревьях
+// map<слово, map<id, частота>> против непрерывных списков InvertedIndex.
+// Память дерева - оценка: узел красно-черного дерева хранит 32 байта служебных полей
+void BenchmarkIndexLayouts(const vector<string>& texts, const vector<string>& queries,
+    double& checksum, ostream& out) {
+    map<string_view, map<int, double>> tree_index;
+    InvertedIndex postings_index;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        for (const auto& [word, term_freq] : ComputeWordFreqs(texts[i])) {
+            tree_index[word][static_cast<int>(i)] = term_freq;
+            postings_index.Add(word, static_cast<int>(i), term_freq);
+        }
+    }
+    const size_t posting_count = postings_index.GetPostingCount();
+    constexpr size_t tree_node_overhead = 32;
+    const size_t tree_bytes = tree_index.size() * (tree_node_overhead + sizeof(pair<const string_view, map<int, double>>))
+        + posting_count * (tree_node_overhead + sizeof(pair<const int, double>));
+
+    // Элементы этапа - пройденные пары (документ, частота), их количество одинаково для обоих индексов
+    vector<vector<string_view>> query_words;
+    vector<size_t> query_posting_counts;
+    for (const string& query : queries) {
+        query_words.push_back(SplitIntoWordsView(query));
+        size_t count = 0;
+        for (string_view word : query_words.back()) {
+            const PostingList* postings = postings_index.Find(word);
+            count += postings == nullptr ? 0 : postings->size();
+        }
+        query_posting_counts.push_back(count);
+    }
+    {
+        StageTimer timer("layout_map_map"s);
+        timer.AddMetric("bytes_per_posting"s, static_cast<double>(tree_bytes) / posting_count);
+        for (size_t i = 0; i < query_words.size(); ++i) {
+            timer.Measure(query_posting_counts[i], [&] {
+                for (string_view word : query_words[i]) {
+                    const auto it = tree_index.find(word);
+                    if (it == tree_index.end()) {
+                        continue;
+                    }
+                    for (const auto& [document_id, term_freq] : it->second) {
+                        checksum += document_id * term_freq;
+                    }
+                }
+            });
+        }
+        timer.Report(out);
+    }
+    {
+        StageTimer timer("layout_postings"s);
+        timer.AddMetric("bytes_per_posting"s, static_cast<double>(postings_index.GetMemoryUsage()) / posting_count);
+        for (size_t i = 0; i < query_words.size(); ++i) {
+            timer.Measure(query_posting_counts[i], [&] {
+                for (string_view word : query_words[i]) {
+                    const PostingList* postings = postings_index.Find(word);
+                    if (postings == nullptr) {
+                        continue;
+                    }
+                    for (size_t j = 0; j < postings->size(); ++j) {
+                        checksum += postings->ordinals[j] * postings->term_freqs[j];
+                    }
+                }
+            });
+        }
+        timer.Report(out);
+    }
+}
+
+// Память и скорость обхода списков документов в несжатом и сжатом формате:
+// каждая операция - проход по всем спискам индекса, элементы - распакованные пары (документ, частота)
+void BenchmarkPostingsDecode(const vector<string>& texts, double& checksum, ostream& out) {
+    InvertedIndex index;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        const auto word_freqs = ComputeWordFreqs(texts[i]);
+        index.SetDocumentWordCount(static_cast<int>(i), SplitIntoWordsView(texts[i]).size());
+        for (const auto& [word, term_freq] : word_freqs) {
+            index.Add(word, static_cast<int>(i), term_freq);
+        }
+    }
+    const size_t posting_count = index.GetPostingCount();
+    const int pass_count = 10;
+    for (const auto& [name, format] : POSTINGS_FORMAT_NAMES) {
+        index.SetPostingsFormat(format);
+        StageTimer timer("postings_decode_"s + string(name));
+        timer.AddMetric("bytes_per_posting"s, static_cast<double>(index.GetMemoryUsage()) / posting_count);
+        for (int pass = 0; pass < pass_count; ++pass) {
+            timer.Measure(posting_count, [&] {
+                for (const auto& [_, postings] : index) {
+                    index.ForEachPosting(postings, [&checksum](int ordinal, double term_freq) {
+                        checksum += ordinal * term_freq;
+                    });
+                }
+            });
+        }
+        timer.Report(out);
+    }
+}
+
+// Разбиение документов на слова с отсевом стоп-слов: вектор слов и std::set
+// против потокового разбиения ForEachWord и StringHashSet. Элементы - слова документов
+void BenchmarkTokenization(const vector<string>& texts, const vector<string>& stop_words, double& checksum,
+    ostream& out) {
+    const set<string, less<>> stop_word_set(stop_words.begin(), stop_words.end());
+    StringHashSet stop_word_hash_set;
+    for (const string& stop_word : stop_words) {
+        stop_word_hash_set.Insert(stop_word);
+    }
+    vector<size_t> word_counts;
+    word_counts.reserve(texts.size());
+    for (const string& text : texts) {
+        size_t word_count = 0;
+        ForEachWord(text, [&word_count](string_view, bool) {
+            ++word_count;
+        });
+        word_counts.push_back(word_count);
+    }
+
+    size_t set_word_count = 0;
+    {
+        StageTimer timer("tokenize_set"s);
+        for (size_t i = 0; i < texts.size(); ++i) {
+            timer.Measure(word_counts[i], [&] {
+                for (string_view word : SplitIntoWordsView(texts[i])) {
+                    set_word_count += stop_word_set.count(word) == 0;
+                }
+            });
+        }
+        timer.Report(out);
+    }
+    size_t hash_word_count = 0;
+    {
+        StageTimer timer("tokenize_hash"s);
+        for (size_t i = 0; i < texts.size(); ++i) {
+            timer.Measure(word_counts[i], [&] {
+                ForEachWord(texts[i], [&](string_view word, bool) {
+                    hash_word_count += !stop_word_hash_set.Contains(word);
+                });
+            });
+        }
+        timer.Report(out);
+    }
+    if (set_word_count != hash_word_count) {
+        throw logic_error("Stop word filters disagree"s);
+    }
+    checksum += static_cast<double>(set_word_count);
+}
+
+// Запуск сервера из снимка против построения индекса заново по текстам документов.
+// Каждая операция - построение или загрузка всего сервера, элементы - документы.
+// Выдача загруженного сервера сверяется с построенным
+void BenchmarkSnapshot(const vector<string>& texts, const vector<string>& queries, const vector<string>& stop_words,
+    double& checksum, ostream& out) {
+    vector<NewDocument> documents;
+    documents.reserve(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        documents.push_back({ static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, { 1 } });
+    }
+    const int pass_count = 3;
+    SearchServer rebuilt_server(stop_words);
+    {
+        StageTimer timer("snapshot_rebuild"s);
+        for (int pass = 0; pass < pass_count; ++pass) {
+            timer.Measure(texts.size(), [&] {
+                rebuilt_server = SearchServer(stop_words);
+                rebuilt_server.AddDocuments(execution::par, documents);
+            });
+        }
+        timer.Report(out);
+    }
+
+    const string path = (filesystem::temp_directory_path() / "search_server_benchmark.snapshot"s).string();
+    rebuilt_server.SaveSnapshot(path);
+    SearchServer loaded_server(stop_words);
+    {
+        StageTimer timer("snapshot_load"s);
+        timer.AddMetric("snapshot_bytes"s, static_cast<double>(filesystem::file_size(path)));
+        for (int pass = 0; pass < pass_count; ++pass) {
+            timer.Measure(texts.size(), [&] { loaded_server = SearchServer::LoadSnapshot(path); });
+        }
+        timer.Report(out);
+    }
+    filesystem::remove(path);
+
+    for (const string& query : queries) {
+        const auto loaded_documents = loaded_server.FindTopDocuments(query);
+        if (loaded_documents.size() != rebuilt_server.FindTopDocuments(query).size()) {
+            throw logic_error("Loaded snapshot disagrees with rebuilt index"s);
+        }
+        checksum += static_cast<double>(loaded_documents.size());
+    }
+}
+
+void ReportOptions(const BenchmarkOptions& options, size_t thread_count, ostream& out) {
+    out << "{\"config\":{\"documents\":"s << options.documents << ",\"queries\":"s << options.queries
+        << ",\"vocabulary\":"s << options.vocabulary << ",\"zipf\":"s << options.zipf
+        << ",\"min_document_words\":"s << options.min_document_words
+        << ",\"max_document_words\":"s << options.max_document_words
+        << ",\"max_query_words\":"s << options.max_query_words << ",\"stop_words\":"s << options.stop_words
+        << ",\"minus_words\":"s << options.minus_words << ",\"duplicates\":"s << options.duplicates
+        << ",\"batch\":"s << options.batch << ",\"removals\":"s << options.removals
+        << ",\"threads\":"s << thread_count << ",\"seed\":"s << options.seed
+        << ",\"evaluation\":\""s << GetEnumName(options.evaluation, QUERY_EVALUATION_NAMES)
+        << "\",\"accumulation\":\""s << GetEnumName(options.accumulation, PARALLEL_ACCUMULATION_NAMES)
+        << "\",\"postings_format\":\""s << GetEnumName(options.postings_format, POSTINGS_FORMAT_NAMES) << "\"}}"s << endl;
+}
+
+void RunBenchmarks(const BenchmarkOptions& options, ostream& out) {
+    Corpus corpus(options);
+    SearchServer search_server(corpus.GetStopWords());
+    if (options.threads > 0) {
+        search_server.SetThreadPool(make_shared<ThreadPool>(options.threads));
+    }
+    search_server.SetQueryEvaluation(options.evaluation);
+    search_server.SetParallelAccumulation(options.accumulation);
+    search_server.SetPostingsFormat(options.postings_format);
+    ReportOptions(options, search_server.GetThreadPool().GetThreadCount(), out);
+
+    {
+        StageTimer timer("index_par"s);
+        vector<string> texts;
+        vector<NewDocument> documents;
+        for (size_t first = 0; first < options.documents; first += options.batch) {
+            const size_t count = min(options.batch, options.documents - first);
+            corpus.GenerateBatch(static_cast<int>(first), count, texts, documents);
+            timer.Measure(count, [&] { search_server.AddDocuments(execution::par, documents); });
+        }
+        timer.Report(out);
+    }
+
+    const vector<string> queries = corpus.GenerateQueries(options.queries);
+    size_t result_count = 0;
+    {
+        StageTimer timer("find_seq"s);
+        for (const string& query : queries) {
+            timer.Measure(1, [&] { result_count += search_server.FindTopDocuments(query).size(); });
+        }
+        timer.Report(out);
+    }
+    {
+        StageTimer timer("find_par"s);
+        for (const string& query : queries) {
+            timer.Measure(1, [&] { result_count += search_server.FindTopDocuments(execution::par, query).size(); });
+        }
+        timer.Report(out);
+    }
+    {
+        StageTimer timer("process_queries"s);
+        for (size_t first = 0; first < queries.size(); first += options.batch) {
+            const vector<string> batch(queries.begin() + first,
+                queries.begin() + min(queries.size(), first + options.batch));
+            timer.Measure(batch.size(), [&] { result_count += ProcessQueries(search_server, batch).size(); });
+        }
+        timer.Report(out);
+    }
+
+    // Запросы сопоставляются со случайными документами
+    vector<int> match_ids(queries.size());
+    for (int& id : match_ids) {
+        id = static_cast<int>(corpus.GetRandom().Below(options.documents));
+    }
+    {
+        StageTimer timer("match_seq"s);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            timer.Measure(1, [&] { result_count += get<0>(search_server.MatchDocument(queries[i], match_ids[i])).size(); });
+        }
+        timer.Report(out);
+    }
+    {
+        StageTimer timer("match_par"s);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            timer.Measure(1, [&] {
+                result_count += get<0>(search_server.MatchDocument(execution::par, queries[i], match_ids[i])).size();
+            });
+        }
+        timer.Report(out);
+    }
+    {
+        // Запрос сопоставляется со страницей выдачи из page_size случайных документов
+        const size_t page_size = 20;
+        StageTimer timer("match_batch"s);
+        DocumentMatches matches;
+        vector<int> page(page_size);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            for (int& id : page) {
+                id = static_cast<int>(corpus.GetRandom().Below(options.documents));
+            }
+            timer.Measure(page.size(), [&] {
+                search_server.MatchDocuments(queries[i], page, matches);
+                for (size_t j = 0; j < matches.GetDocumentCount(); ++j) {
+                    result_count += matches.GetWords(j).size();
+                }
+            });
+        }
+        timer.Report(out);
+    }
+
+    // Последовательное и параллельное удаление разных случайных документов
+    vector<int> remove_ids(options.documents);
+    for (size_t i = 0; i < remove_ids.size(); ++i) {
+        remove_ids[i] = static_cast<int>(i);
+    }
+    const size_t removal_count = min(options.removals, remove_ids.size() / 2);
+    for (size_t i = 0; i < 2 * removal_count; ++i) {
+        swap(remove_ids[i], remove_ids[i + corpus.GetRandom().Below(remove_ids.size() - i)]);
+    }
+    {
+        StageTimer timer("remove_seq"s);
+        for (size_t i = 0; i < removal_count; ++i) {
+            timer.Measure(1, [&] { search_server.RemoveDocument(remove_ids[i]); });
+        }
+        timer.Report(out);
+    }
+    {
+        StageTimer timer("remove_par"s);
+        for (size_t i = removal_count; i < 2 * removal_count; ++i) {
+            timer.Measure(1, [&] { search_server.RemoveDocument(execution::par, remove_ids[i]); });
+        }
+        timer.Report(out);
+    }
+    {
+        StageTimer timer("remove_duplicates_par"s);
+        timer.Measure(search_server.GetDocumentCount(), [&] {
+            result_count += RemoveDuplicates(execution::par, search_server).size();
+        });
+        timer.Report(out);
+    }
+
+    // Сравнение структур на текстах документов корпуса
+    const vector<string> texts = GenerateDocumentTexts(options);
+    double checksum = 0.0;
+    BenchmarkIndexLayouts(texts, queries, checksum, out);
+    BenchmarkPostingsDecode(texts, checksum, out);
+    vector<string> stop_words;
+    for (size_t rank = 0; rank < options.stop_words; ++rank) {
+        stop_words.push_back(MakeWord(rank));
+    }
+    BenchmarkTokenization(texts, stop_words, checksum, out);
+    BenchmarkSnapshot(texts, queries, stop_words, checksum, out);
+
+    // Сумма результатов не дает компилятору выбросить вызовы
+    cerr << "results: "s << result_count << ' ' << checksum << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        RunBenchmarks(ParseOptions(argc, argv), cout);
+    }
+    catch (const exception& e) {
+        cerr << e.what() << endl;
+        cerr << "Usage: search_server_benchmark [--documents N] [--queries N] [--vocabulary N] [--zipf S]"s
+            " [--min-document-words N] [--max-document-words N] [--max-query-words N] [--stop-words N]"s
+            " [--minus-words SHARE] [--duplicates SHARE] [--batch N] [--removals N] [--threads N] [--seed N]"s
+            " [--evaluation exhaustive|max_score] [--accumulation concurrent_map|partial_tables|document_ranges]"s
+            " [--postings-format raw|compressed]"s << endl;
+        return 1;
+    }
+}
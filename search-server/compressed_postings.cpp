@@ -0,0 +1,378 @@
+#include "compressed_postings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t LANE_COUNT = 4;
+constexpr size_t LANE_SIZE = CompressedPostingList::BLOCK_SIZE / LANE_COUNT;
+
+uint8_t GetBitWidth(uint32_t max_value) {
+    return max_value == 0 ? 0 : static_cast<uint8_t>(32 - __builtin_clz(max_value));
+}
+
+// Упаковывает BLOCK_SIZE значений по bits бит: значение i пишется в дорожку i % 4,
+// дорожки чередуются в packed по 32-битным словам. packed содержит 4 * bits обнуленных слов
+void PackValues(const uint32_t* values, uint8_t bits, uint32_t* packed) {
+    if (bits == 0) {
+        return;
+    }
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+        size_t bit = 0;
+        for (size_t i = 0; i < LANE_SIZE; ++i, bit += bits) {
+            const uint32_t value = values[i * LANE_COUNT + lane];
+            const size_t word = bit / 32;
+            const size_t shift = bit % 32;
+            packed[word * LANE_COUNT + lane] |= value << shift;
+            if (shift + bits > 32) {
+                packed[(word + 1) * LANE_COUNT + lane] |= value >> (32 - shift);
+            }
+        }
+    }
+}
+
+// Распаковывает первые group_count четверок значений
+void UnpackValues(const uint32_t* packed, uint8_t bits, size_t group_count, uint32_t* values) {
+    if (bits == 0) {
+        std::fill(values, values + group_count * LANE_COUNT, 0);
+        return;
+    }
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi32(bits == 32 ? -1 : static_cast<int>((1u << bits) - 1));
+    const __m128i* words = reinterpret_cast<const __m128i*>(packed);
+    size_t word = 0;
+    int shift = 0;
+    __m128i current = _mm_loadu_si128(words);
+    for (size_t i = 0; i < group_count; ++i) {
+        __m128i value = _mm_srl_epi32(current, _mm_cvtsi32_si128(shift));
+        if (shift + bits >= 32) {
+            // Значение заканчивается в следующем слове
+            if (++word < bits) {
+                current = _mm_loadu_si128(words + word);
+                if (shift + bits > 32) {
+                    value = _mm_or_si128(value, _mm_sll_epi32(current, _mm_cvtsi32_si128(32 - shift)));
+                }
+            }
+            shift += bits - 32;
+        }
+        else {
+            shift += bits;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i * LANE_COUNT), _mm_and_si128(value, mask));
+    }
+#else
+    const uint32_t mask = bits == 32 ? ~0u : (1u << bits) - 1;
+    for (size_t lane = 0; lane < LANE_COUNT; ++lane) {
+        size_t bit = 0;
+        for (size_t i = 0; i < group_count; ++i, bit += bits) {
+            const size_t word = bit / 32;
+            const size_t shift = bit % 32;
+            uint32_t value = packed[word * LANE_COUNT + lane] >> shift;
+            if (shift + bits > 32) {
+                value |= packed[(word + 1) * LANE_COUNT + lane] << (32 - shift);
+            }
+            values[i * LANE_COUNT + lane] = value & mask;
+        }
+    }
+#endif
+}
+
+// Восстанавливает номера: ordinals[i] = first_ordinal + i + (deltas[0] + ... + deltas[i])
+void RestoreOrdinals(const uint32_t* deltas, int first_ordinal, size_t group_count, int* ordinals) {
+#ifdef __SSE2__
+    __m128i carry = _mm_setzero_si128();
+    __m128i base = _mm_add_epi32(_mm_set1_epi32(first_ordinal), _mm_setr_epi32(0, 1, 2, 3));
+    const __m128i step = _mm_set1_epi32(LANE_COUNT);
+    for (size_t i = 0; i < group_count; ++i) {
+        __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas + i * LANE_COUNT));
+        sum = _mm_add_epi32(sum, _mm_slli_si128(sum, 4));
+        sum = _mm_add_epi32(sum, _mm_slli_si128(sum, 8));
+        sum = _mm_add_epi32(sum, carry);
+        carry = _mm_shuffle_epi32(sum, _MM_SHUFFLE(3, 3, 3, 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ordinals + i * LANE_COUNT), _mm_add_epi32(sum, base));
+        base = _mm_add_epi32(base, step);
+    }
+#else
+    uint32_t sum = 0;
+    for (size_t i = 0; i < group_count * LANE_COUNT; ++i) {
+        sum += deltas[i];
+        ordinals[i] = first_ordinal + static_cast<int>(i + sum);
+    }
+#endif
+}
+
+size_t GetGroupCount(size_t count) {
+    return (count + LANE_COUNT - 1) / LANE_COUNT;
+}
+
+} // namespace
+
+void CompressedPostingList::Assign(const std::vector<int>& ordinals, const std::vector<double>& term_freqs,
+    const std::vector<double>& inverse_word_counts) {
+    std::vector<uint32_t> counts(ordinals.size());
+    bool exact_counts = true;
+    for (size_t i = 0; i < ordinals.size() && exact_counts; ++i) {
+        counts[i] = FindCount(ordinals[i], term_freqs[i], inverse_word_counts);
+        exact_counts = counts[i] != 0;
+    }
+
+    blocks_.clear();
+    packed_.clear();
+    term_freqs_.clear();
+    exact_counts_ = exact_counts;
+    for (size_t begin = 0; begin < ordinals.size(); begin += BLOCK_SIZE) {
+        const size_t count = std::min(BLOCK_SIZE, ordinals.size() - begin);
+        Block block = EncodeBlock(ordinals.data() + begin, counts.data() + begin, count, exact_counts_, packed_);
+        block.first_posting = static_cast<uint32_t>(begin);
+        blocks_.push_back(block);
+    }
+    if (!exact_counts_) {
+        term_freqs_ = term_freqs;
+    }
+    size_ = ordinals.size();
+}
+
+void CompressedPostingList::Add(int ordinal, double term_freq, const std::vector<double>& inverse_word_counts) {
+    uint32_t count = 0;
+    if (exact_counts_) {
+        count = FindCount(ordinal, term_freq, inverse_word_counts);
+        if (count == 0) {
+            StoreTermFreqs(inverse_word_counts);
+        }
+    }
+
+    if (!blocks_.empty() && ordinal <= blocks_.back().last_ordinal) {
+        // Вставка в середину списка редка: номера документов выдаются по возрастанию
+        std::vector<int> ordinals;
+        std::vector<double> term_freqs;
+        Decode(ordinals, term_freqs, inverse_word_counts);
+        const auto it = std::lower_bound(ordinals.begin(), ordinals.end(), ordinal);
+        const auto pos = it - ordinals.begin();
+        if (it != ordinals.end() && *it == ordinal) {
+            term_freqs[pos] += term_freq;
+        }
+        else {
+            ordinals.insert(it, ordinal);
+            term_freqs.insert(term_freqs.begin() + pos, term_freq);
+        }
+        Assign(ordinals, term_freqs, inverse_word_counts);
+        return;
+    }
+
+    if (blocks_.empty() || blocks_.back().count == BLOCK_SIZE) {
+        Block block = EncodeBlock(&ordinal, &count, 1, exact_counts_, packed_);
+        block.first_posting = static_cast<uint32_t>(size_);
+        blocks_.push_back(block);
+    }
+    else {
+        int ordinals[BLOCK_SIZE];
+        uint32_t counts[BLOCK_SIZE];
+        const size_t block_count = DecodeBlockCounts(blocks_.size() - 1, ordinals, counts);
+        ordinals[block_count] = ordinal;
+        counts[block_count] = count;
+        ReplaceBlock(blocks_.size() - 1, ordinals, counts, block_count + 1);
+    }
+    if (!exact_counts_) {
+        term_freqs_.push_back(term_freq);
+    }
+    ++size_;
+}
+
+void CompressedPostingList::Remove(int ordinal) {
+    const size_t block = FindBlock(ordinal);
+    if (block == blocks_.size() || blocks_[block].first_ordinal > ordinal) {
+        return;
+    }
+    int ordinals[BLOCK_SIZE];
+    uint32_t counts[BLOCK_SIZE];
+    const size_t count = DecodeBlockCounts(block, ordinals, counts);
+    const size_t pos = std::lower_bound(ordinals, ordinals + count, ordinal) - ordinals;
+    if (pos == count || ordinals[pos] != ordinal) {
+        return;
+    }
+    const uint32_t first_posting = blocks_[block].first_posting;
+    std::copy(ordinals + pos + 1, ordinals + count, ordinals + pos);
+    std::copy(counts + pos + 1, counts + count, counts + pos);
+    ReplaceBlock(block, ordinals, counts, count - 1);
+    if (!exact_counts_) {
+        term_freqs_.erase(term_freqs_.begin() + first_posting + pos);
+    }
+    // Номера документов в списке у следующих блоков уменьшились на 1
+    for (size_t i = count > 1 ? block + 1 : block; i < blocks_.size(); ++i) {
+        --blocks_[i].first_posting;
+    }
+    --size_;
+}
+
+void CompressedPostingList::Decode(std::vector<int>& ordinals, std::vector<double>& term_freqs,
+    const std::vector<double>& inverse_word_counts) const {
+    ordinals.resize(size_ + BLOCK_SIZE);
+    term_freqs.resize(size_ + BLOCK_SIZE);
+    for (size_t block = 0; block < blocks_.size(); ++block) {
+        const size_t first_posting = blocks_[block].first_posting;
+        DecodeBlock(block, ordinals.data() + first_posting, term_freqs.data() + first_posting, inverse_word_counts);
+    }
+    ordinals.resize(size_);
+    term_freqs.resize(size_);
+}
+
+size_t CompressedPostingList::DecodeBlockOrdinals(size_t block, int* ordinals) const {
+    const Block& header = blocks_[block];
+    const size_t group_count = GetGroupCount(header.count);
+    uint32_t deltas[BLOCK_SIZE];
+    UnpackValues(packed_.data() + header.packed_offset, header.ordinal_bits, group_count, deltas);
+    RestoreOrdinals(deltas, header.first_ordinal, group_count, ordinals);
+    return header.count;
+}
+
+size_t CompressedPostingList::DecodeBlock(size_t block, int* ordinals, double* term_freqs,
+    const std::vector<double>& inverse_word_counts) const {
+    const size_t count = DecodeBlockOrdinals(block, ordinals);
+    DecodeBlockTermFreqs(block, ordinals, term_freqs, inverse_word_counts);
+    return count;
+}
+
+void CompressedPostingList::DecodeBlockTermFreqs(size_t block, const int* ordinals, double* term_freqs,
+    const std::vector<double>& inverse_word_counts) const {
+    const Block& header = blocks_[block];
+    if (!exact_counts_) {
+        std::copy_n(term_freqs_.begin() + header.first_posting, header.count, term_freqs);
+        return;
+    }
+    uint32_t counts[BLOCK_SIZE];
+    UnpackValues(packed_.data() + header.packed_offset + header.ordinal_bits * LANE_COUNT,
+        header.count_bits, GetGroupCount(header.count), counts);
+    for (size_t i = 0; i < header.count; ++i) {
+        term_freqs[i] = static_cast<double>(counts[i] + 1) * inverse_word_counts[ordinals[i]];
+    }
+}
+
+size_t CompressedPostingList::FindBlock(int ordinal, size_t first_block) const {
+    return std::partition_point(blocks_.begin() + first_block, blocks_.end(),
+        [ordinal](const Block& block) { return block.last_ordinal < ordinal; }) - blocks_.begin();
+}
+
+void CompressedPostingList::ShrinkToFit() {
+    blocks_.shrink_to_fit();
+    packed_.shrink_to_fit();
+    term_freqs_.shrink_to_fit();
+}
+
+size_t CompressedPostingList::GetMemoryUsage() const {
+    return blocks_.capacity() * sizeof(Block) + packed_.capacity() * sizeof(uint32_t)
+        + term_freqs_.capacity() * sizeof(double);
+}
+
+uint32_t CompressedPostingList::FindCount(int ordinal, double term_freq,
+    const std::vector<double>& inverse_word_counts) {
+    if (ordinal < 0 || static_cast<size_t>(ordinal) >= inverse_word_counts.size()
+        || inverse_word_counts[ordinal] <= 0.0) {
+        return 0;
+    }
+    const double inverse_word_count = inverse_word_counts[ordinal];
+    const double count = std::round(term_freq / inverse_word_count);
+    if (count < 1.0 || count > std::numeric_limits<uint32_t>::max()
+        || count * inverse_word_count != term_freq) {
+        return 0;
+    }
+    return static_cast<uint32_t>(count);
+}
+
+size_t CompressedPostingList::DecodeBlockCounts(size_t block, int* ordinals, uint32_t* counts) const {
+    const size_t count = DecodeBlockOrdinals(block, ordinals);
+    const Block& header = blocks_[block];
+    if (exact_counts_) {
+        UnpackValues(packed_.data() + header.packed_offset + header.ordinal_bits * LANE_COUNT,
+            header.count_bits, GetGroupCount(count), counts);
+        for (size_t i = 0; i < count; ++i) {
+            ++counts[i];
+        }
+    }
+    return count;
+}
+
+void CompressedPostingList::ReplaceBlock(size_t block, const int* ordinals, const uint32_t* counts, size_t count) {
+    const Block old_block = blocks_[block];
+    const auto old_begin = packed_.begin() + old_block.packed_offset;
+    const size_t old_size = (old_block.ordinal_bits + old_block.count_bits) * LANE_COUNT;
+
+    std::vector<uint32_t> packed;
+    Block new_block{};
+    if (count > 0) {
+        new_block = EncodeBlock(ordinals, counts, count, exact_counts_, packed);
+    }
+    // Замена упакованных данных на месте со сдвигом хвоста при изменении размера
+    if (packed.size() <= old_size) {
+        std::copy(packed.begin(), packed.end(), old_begin);
+        packed_.erase(old_begin + packed.size(), old_begin + old_size);
+    }
+    else {
+        std::copy(packed.begin(), packed.begin() + old_size, old_begin);
+        packed_.insert(old_begin + old_size, packed.begin() + old_size, packed.end());
+    }
+    const auto size_change = static_cast<int64_t>(packed.size()) - static_cast<int64_t>(old_size);
+    for (size_t i = block + 1; i < blocks_.size(); ++i) {
+        blocks_[i].packed_offset = static_cast<uint32_t>(blocks_[i].packed_offset + size_change);
+    }
+
+    if (count == 0) {
+        blocks_.erase(blocks_.begin() + block);
+        return;
+    }
+    new_block.packed_offset = old_block.packed_offset;
+    new_block.first_posting = old_block.first_posting;
+    blocks_[block] = new_block;
+}
+
+CompressedPostingList::Block CompressedPostingList::EncodeBlock(const int* ordinals, const uint32_t* counts,
+    size_t count, bool with_counts, std::vector<uint32_t>& packed) {
+    uint32_t deltas[BLOCK_SIZE] = {};
+    uint32_t max_delta = 0;
+    for (size_t i = 1; i < count; ++i) {
+        deltas[i] = static_cast<uint32_t>(ordinals[i] - ordinals[i - 1] - 1);
+        max_delta = std::max(max_delta, deltas[i]);
+    }
+    uint32_t count_values[BLOCK_SIZE] = {};
+    uint32_t max_count = 0;
+    if (with_counts) {
+        for (size_t i = 0; i < count; ++i) {
+            count_values[i] = counts[i] - 1;
+            max_count = std::max(max_count, count_values[i]);
+        }
+    }
+
+    Block block{};
+    block.first_ordinal = ordinals[0];
+    block.last_ordinal = ordinals[count - 1];
+    block.packed_offset = static_cast<uint32_t>(packed.size());
+    block.count = static_cast<uint16_t>(count);
+    block.ordinal_bits = GetBitWidth(max_delta);
+    block.count_bits = GetBitWidth(max_count);
+    packed.resize(packed.size() + (block.ordinal_bits + block.count_bits) * LANE_COUNT, 0);
+    PackValues(deltas, block.ordinal_bits, packed.data() + block.packed_offset);
+    PackValues(count_values, block.count_bits, packed.data() + block.packed_offset + block.ordinal_bits * LANE_COUNT);
+    return block;
+}
+
+void CompressedPostingList::StoreTermFreqs(const std::vector<double>& inverse_word_counts) {
+    std::vector<int> ordinals;
+    std::vector<double> term_freqs;
+    Decode(ordinals, term_freqs, inverse_word_counts);
+
+    blocks_.clear();
+    packed_.clear();
+    exact_counts_ = false;
+    for (size_t begin = 0; begin < ordinals.size(); begin += BLOCK_SIZE) {
+        const size_t count = std::min(BLOCK_SIZE, ordinals.size() - begin);
+        Block block = EncodeBlock(ordinals.data() + begin, nullptr, count, false, packed_);
+        block.first_posting = static_cast<uint32_t>(begin);
+        blocks_.push_back(block);
+    }
+    term_freqs_ = std::move(term_freqs);
+}
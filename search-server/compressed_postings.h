@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Сжатый список документов слова.
+// Документы делятся на блоки по BLOCK_SIZE. Блок хранит первый и последний
+// порядковые номера, разности соседних номеров (минус 1) и количества вхождений
+// слова (минус 1), упакованные по минимальному для блока числу бит.
+// Упаковка вертикальная: значение i блока лежит в 32-битной дорожке i % 4
+// 128-битного слова, поэтому блок распаковывается сдвигами и масками SSE2
+// сразу по 4 значения, а номера восстанавливаются префиксной суммой в регистре.
+// Частота слова восстанавливается как количество вхождений, умноженное на
+// inverse_word_counts[ordinal] (1 / количество слов документа) - так же, как ее
+// считает сервер, поэтому без потерь. Если частоту нельзя так представить,
+// список хранит частоты без сжатия
+class CompressedPostingList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    // Кодирует отсортированный список документов
+    void Assign(const std::vector<int>& ordinals, const std::vector<double>& term_freqs,
+        const std::vector<double>& inverse_word_counts);
+
+    // Добавляет документ. Если номер больше имеющихся, перекодируется только последний блок
+    void Add(int ordinal, double term_freq, const std::vector<double>& inverse_word_counts);
+
+    // Удаляет документ, перекодируя только его блок
+    void Remove(int ordinal);
+
+    // Распаковывает весь список
+    void Decode(std::vector<int>& ordinals, std::vector<double>& term_freqs,
+        const std::vector<double>& inverse_word_counts) const;
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t GetBlockCount() const {
+        return blocks_.size();
+    }
+
+    int GetBlockFirstOrdinal(size_t block) const {
+        return blocks_[block].first_ordinal;
+    }
+
+    int GetBlockLastOrdinal(size_t block) const {
+        return blocks_[block].last_ordinal;
+    }
+
+    // Распаковывает номера документов блока в ordinals[0..BLOCK_SIZE).
+    // Возвращает количество документов блока
+    size_t DecodeBlockOrdinals(size_t block, int* ordinals) const;
+
+    // Распаковывает номера и частоты блока в массивы из BLOCK_SIZE элементов
+    size_t DecodeBlock(size_t block, int* ordinals, double* term_freqs,
+        const std::vector<double>& inverse_word_counts) const;
+
+    // Распаковывает частоты блока, номера документов которого уже распакованы в ordinals
+    void DecodeBlockTermFreqs(size_t block, const int* ordinals, double* term_freqs,
+        const std::vector<double>& inverse_word_counts) const;
+
+    // Возвращает первый блок, начиная с first_block, последний номер которого не меньше ordinal,
+    // или GetBlockCount(), если такого нет. Блоки пропускаются без распаковки
+    size_t FindBlock(int ordinal, size_t first_block = 0) const;
+
+    // Вызывает callback(ordinal, term_freq) для документов по возрастанию номеров
+    template <typename Callback>
+    void ForEach(const std::vector<double>& inverse_word_counts, Callback callback) const {
+        int ordinals[BLOCK_SIZE];
+        double term_freqs[BLOCK_SIZE];
+        for (size_t block = 0; block < blocks_.size(); ++block) {
+            const size_t count = DecodeBlock(block, ordinals, term_freqs, inverse_word_counts);
+            for (size_t i = 0; i < count; ++i) {
+                callback(ordinals[i], term_freqs[i]);
+            }
+        }
+    }
+
+    // Вызывает callback(ordinal) для документов по возрастанию номеров
+    template <typename Callback>
+    void ForEachOrdinal(Callback callback) const {
+        int ordinals[BLOCK_SIZE];
+        for (size_t block = 0; block < blocks_.size(); ++block) {
+            const size_t count = DecodeBlockOrdinals(block, ordinals);
+            for (size_t i = 0; i < count; ++i) {
+                callback(ordinals[i]);
+            }
+        }
+    }
+
+    void ShrinkToFit();
+
+    size_t GetMemoryUsage() const;
+
+private:
+    // Блок: packed_offset - начало упакованных данных в packed_ (разности номеров,
+    // затем количества вхождений); first_posting - номер первого документа блока
+    // в списке, по нему находятся несжатые частоты
+    struct Block {
+        int first_ordinal;
+        int last_ordinal;
+        uint32_t packed_offset;
+        uint32_t first_posting;
+        uint16_t count;
+        uint8_t ordinal_bits;
+        uint8_t count_bits;
+    };
+
+    std::vector<Block> blocks_;
+    std::vector<uint32_t> packed_;
+    // Несжатые частоты, если их нельзя представить количеством вхождений
+    std::vector<double> term_freqs_;
+    bool exact_counts_ = true;
+    size_t size_ = 0;
+
+    // Количество вхождений слова, дающее частоту term_freq, или 0, если такого нет
+    static uint32_t FindCount(int ordinal, double term_freq, const std::vector<double>& inverse_word_counts);
+
+    // Распаковывает номера и количества вхождений блока
+    size_t DecodeBlockCounts(size_t block, int* ordinals, uint32_t* counts) const;
+
+    // Заменяет блок новым содержимым; при count == 0 блок удаляется
+    void ReplaceBlock(size_t block, const int* ordinals, const uint32_t* counts, size_t count);
+
+    // Упаковывает документы блока в конец packed
+    static Block EncodeBlock(const int* ordinals, const uint32_t* counts, size_t count,
+        bool with_counts, std::vector<uint32_t>& packed);
+
+    // Переходит к хранению несжатых частот
+    void StoreTermFreqs(const std::vector<double>& inverse_word_counts);
+};
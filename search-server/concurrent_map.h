@@ -1,8 +1,10 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 
@@ -52,3 +54,72 @@ public:
 private:
     std::vector<Bucket_> buckets_;
 };
+
+// Потокобезопасный пул переиспользуемых объектов.
+// Объект берется из пула на время задачи и возвращается при разрушении Handle,
+// поэтому блокировка берется только при взятии и возврате объекта
+template <typename Value>
+class ConcurrentPool {
+public:
+    class Handle {
+    public:
+        Handle() = default;
+
+        Handle(ConcurrentPool* pool, std::unique_ptr<Value> value)
+            : pool_(pool)
+            , value_(std::move(value)) {
+        }
+
+        Handle(Handle&& other) = default;
+
+        Handle& operator=(Handle&& other) {
+            if (this != &other) {
+                Release();
+                pool_ = other.pool_;
+                value_ = std::move(other.value_);
+            }
+            return *this;
+        }
+
+        ~Handle() {
+            Release();
+        }
+
+        Value& operator*() const {
+            return *value_;
+        }
+
+        Value* operator->() const {
+            return value_.get();
+        }
+
+    private:
+        void Release() {
+            if (value_) {
+                pool_->Return(std::move(value_));
+            }
+        }
+
+        ConcurrentPool* pool_ = nullptr;
+        std::unique_ptr<Value> value_;
+    };
+
+    Handle Acquire() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (free_values_.empty()) {
+            return { this, std::make_unique<Value>() };
+        }
+        auto value = std::move(free_values_.back());
+        free_values_.pop_back();
+        return { this, std::move(value) };
+    }
+
+private:
+    void Return(std::unique_ptr<Value> value) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        free_values_.push_back(std::move(value));
+    }
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Value>> free_values_;
+};
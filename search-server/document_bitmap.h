@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Множество порядковых номеров документов в виде битового массива. Номера документов
+// плотные, поэтому массив занимает бит на документ, а проверка номера - одно чтение слова
+class DocumentBitmap {
+public:
+    // Количество номеров; добавленные номера не входят в множество
+    void Resize(size_t size) {
+        words_.resize((size + WORD_BITS - 1) / WORD_BITS, 0);
+        size_ = size;
+        // Номера за новой границей не должны остаться в последнем слове
+        if (size % WORD_BITS != 0) {
+            words_.back() &= (uint64_t{ 1 } << (size % WORD_BITS)) - 1;
+        }
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+    bool Test(int ordinal) const {
+        return (words_[static_cast<size_t>(ordinal) / WORD_BITS] >> (ordinal % WORD_BITS)) & 1;
+    }
+
+    void Set(int ordinal) {
+        words_[static_cast<size_t>(ordinal) / WORD_BITS] |= uint64_t{ 1 } << (ordinal % WORD_BITS);
+    }
+
+    void Reset(int ordinal) {
+        words_[static_cast<size_t>(ordinal) / WORD_BITS] &= ~(uint64_t{ 1 } << (ordinal % WORD_BITS));
+    }
+
+    // Убирает все номера, размер сохраняется
+    void Clear() {
+        words_.assign(words_.size(), 0);
+    }
+
+    // Оставляет номера, входящие в оба множества. Размеры должны совпадать
+    void IntersectWith(const DocumentBitmap& other) {
+        for (size_t i = 0; i < words_.size(); ++i) {
+            words_[i] &= other.words_[i];
+        }
+    }
+
+    // Вызывает func(ordinal) для номеров множества по возрастанию
+    template <typename Func>
+    void ForEach(Func func) const {
+        for (size_t i = 0; i < words_.size(); ++i) {
+            for (uint64_t word = words_[i]; word != 0; word &= word - 1) {
+                func(static_cast<int>(i * WORD_BITS + CountTrailingZeros(word)));
+            }
+        }
+    }
+
+private:
+    static constexpr size_t WORD_BITS = 64;
+
+    std::vector<uint64_t> words_;
+    size_t size_ = 0;
+
+    static size_t CountTrailingZeros(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_ctzll(word));
+#else
+        size_t count = 0;
+        for (; (word & 1) == 0; word >>= 1) {
+            ++count;
+        }
+        return count;
+#endif
+    }
+};
@@ -0,0 +1,82 @@
+#include "document_columns.h"
+
+#include <algorithm>
+
+void DocumentColumns::Resize(size_t ordinal_count) {
+    statuses_.resize(ordinal_count, DocumentStatus::REMOVED);
+    ratings_.resize(ordinal_count, 0);
+    for (DocumentBitmap& documents : status_documents_) {
+        documents.Resize(ordinal_count);
+    }
+}
+
+void DocumentColumns::Add(int ordinal, DocumentStatus status, int rating) {
+    statuses_[ordinal] = status;
+    ratings_[ordinal] = rating;
+    status_documents_[static_cast<size_t>(status)].Set(ordinal);
+
+    // Новые документы получают наибольшие номера, поэтому обычно дописываются в конец
+    std::vector<int>& ordinals = rating_to_ordinals_[rating];
+    if (ordinals.empty() || ordinals.back() < ordinal) {
+        ordinals.push_back(ordinal);
+    }
+    else {
+        ordinals.insert(std::lower_bound(ordinals.begin(), ordinals.end(), ordinal), ordinal);
+    }
+    ++document_count_;
+}
+
+void DocumentColumns::Remove(int ordinal) {
+    status_documents_[static_cast<size_t>(statuses_[ordinal])].Reset(ordinal);
+
+    const auto it = rating_to_ordinals_.find(ratings_[ordinal]);
+    std::vector<int>& ordinals = it->second;
+    ordinals.erase(std::lower_bound(ordinals.begin(), ordinals.end(), ordinal));
+    if (ordinals.empty()) {
+        rating_to_ordinals_.erase(it);
+    }
+    --document_count_;
+}
+
+void DocumentColumns::RemapOrdinals(const std::vector<int>& new_ordinals, size_t ordinal_count) {
+    DocumentColumns remapped;
+    remapped.Resize(ordinal_count);
+    for (size_t ordinal = 0; ordinal < new_ordinals.size(); ++ordinal) {
+        const int new_ordinal = new_ordinals[ordinal];
+        if (new_ordinal != -1) {
+            remapped.Add(new_ordinal, statuses_[ordinal], ratings_[ordinal]);
+        }
+    }
+    *this = std::move(remapped);
+}
+
+void DocumentColumns::FindByRating(DocumentStatus status, int min_rating, int max_rating,
+    DocumentBitmap& documents) const {
+    const DocumentBitmap& status_documents = GetStatusDocuments(status);
+    documents.Resize(GetOrdinalCount());
+    documents.Clear();
+    if (min_rating > max_rating) {
+        return;
+    }
+
+    const auto begin = rating_to_ordinals_.lower_bound(min_rating);
+    const auto end = rating_to_ordinals_.upper_bound(max_rating);
+    size_t range_count = 0;
+    for (auto it = begin; it != end; ++it) {
+        range_count += it->second.size();
+    }
+    if (range_count < document_count_ * RATING_INDEX_MAX_SELECTIVITY) {
+        for (auto it = begin; it != end; ++it) {
+            for (const int ordinal : it->second) {
+                documents.Set(ordinal);
+            }
+        }
+        documents.IntersectWith(status_documents);
+        return;
+    }
+    status_documents.ForEach([&](int ordinal) {
+        if (ratings_[ordinal] >= min_rating && ratings_[ordinal] <= max_rating) {
+            documents.Set(ordinal);
+        }
+    });
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "document.h"
+#include "document_bitmap.h"
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// Количество значений DocumentStatus
+const size_t DOCUMENT_STATUS_COUNT = 4;
+
+// Доля документов диапазона рейтингов, ниже которой FindByRating собирает документы
+// по вторичному индексу, а не проверяет рейтинг каждого документа со статусом
+const double RATING_INDEX_MAX_SELECTIVITY = 1.0 / 64;
+
+// Статусы и рейтинги документов по порядковым номерам: при обходе списков документов
+// фильтр читает их без поиска документа по id. Для каждого статуса хранится битовый
+// массив живых документов, для рейтингов - вторичный индекс, отсортированный по рейтингу
+class DocumentColumns {
+public:
+    // Добавляет номера до ordinal_count без документов
+    void Resize(size_t ordinal_count);
+
+    size_t GetOrdinalCount() const {
+        return statuses_.size();
+    }
+
+    // Документ с номером ordinal < GetOrdinalCount() становится живым
+    void Add(int ordinal, DocumentStatus status, int rating);
+
+    // Документ с номером ordinal удален
+    void Remove(int ordinal);
+
+    // Переносит живые документы на номера new_ordinals[ordinal];
+    // -1 - номер удаленного документа. Номеров после переноса ordinal_count
+    void RemapOrdinals(const std::vector<int>& new_ordinals, size_t ordinal_count);
+
+    DocumentStatus GetStatus(int ordinal) const {
+        return statuses_[ordinal];
+    }
+
+    int GetRating(int ordinal) const {
+        return ratings_[ordinal];
+    }
+
+    // Живые документы со статусом status
+    const DocumentBitmap& GetStatusDocuments(DocumentStatus status) const {
+        return status_documents_[static_cast<size_t>(status)];
+    }
+
+    // Записывает в documents живые документы со статусом status и рейтингом
+    // из [min_rating, max_rating]. Узкий диапазон собирается по вторичному индексу
+    // и пересекается с документами статуса, широкий - проверкой рейтингов документов статуса
+    void FindByRating(DocumentStatus status, int min_rating, int max_rating, DocumentBitmap& documents) const;
+
+private:
+    std::vector<DocumentStatus> statuses_;
+    std::vector<int> ratings_;
+    std::array<DocumentBitmap, DOCUMENT_STATUS_COUNT> status_documents_;
+    // Номера живых документов по возрастанию для каждого рейтинга
+    std::map<int, std::vector<int>> rating_to_ordinals_;
+    size_t document_count_ = 0;
+};
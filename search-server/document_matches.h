@@ -0,0 +1,51 @@
+#pragma once
+
+#include "document.h"
+#include "paginator.h"
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Результат пакетной проверки документов SearchServer::MatchDocuments.
+// Каждому документу отведено место под все плюс-слова запроса в общем массиве,
+// поэтому документы заполняются независимо, а повторное использование результата
+// с запросами не длиннее прежних не выделяет память
+class DocumentMatches {
+public:
+    using WordRange = IteratorRange<std::vector<std::string_view>::const_iterator>;
+
+    size_t GetDocumentCount() const {
+        return statuses_.size();
+    }
+
+    // Плюс-слова запроса, найденные в документе с номером index в пакете, по алфавиту.
+    // Пусто, если документ содержит минус-слово
+    WordRange GetWords(size_t index) const {
+        const auto begin = words_.begin() + index * word_capacity_;
+        return WordRange(begin, begin + word_counts_[index]);
+    }
+
+    DocumentStatus GetStatus(size_t index) const {
+        return statuses_[index];
+    }
+
+private:
+    friend class SearchServer;
+
+    // Готовит место для document_count документов по word_capacity слов
+    void Reset(size_t document_count, size_t word_capacity) {
+        word_capacity_ = word_capacity;
+        words_.resize(document_count * word_capacity);
+        word_counts_.assign(document_count, 0);
+        statuses_.resize(document_count);
+        ordinals_.resize(document_count);
+    }
+
+    std::vector<std::string_view> words_;
+    std::vector<size_t> word_counts_;
+    std::vector<DocumentStatus> statuses_;
+    // Порядковые номера документов в индексе сервера
+    std::vector<int> ordinals_;
+    size_t word_capacity_ = 0;
+};
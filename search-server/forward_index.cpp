@@ -0,0 +1,99 @@
+#include "forward_index.h"
+
+#include <algorithm>
+#include <utility>
+
+void ForwardIndex::Borrow(std::shared_ptr<const char[]> block, const uint32_t* term_ids, const double* term_freqs,
+    size_t entry_count) {
+    term_ids_ = {};
+    term_freqs_ = {};
+    borrowed_term_ids_ = term_ids;
+    borrowed_term_freqs_ = term_freqs;
+    borrowed_entry_count_ = entry_count;
+    borrowed_block_ = std::move(block);
+}
+
+void ForwardIndex::SetDocument(int ordinal, size_t begin, size_t word_count) {
+    if (static_cast<size_t>(ordinal) >= ranges_.size()) {
+        ranges_.resize(ordinal + 1);
+    }
+    ranges_[ordinal] = { begin, word_count };
+}
+
+void ForwardIndex::AllocateDocument(int ordinal, size_t word_count) {
+    MakeOwned();
+    if (static_cast<size_t>(ordinal) >= ranges_.size()) {
+        ranges_.resize(ordinal + 1);
+    }
+    ranges_[ordinal] = { term_ids_.size(), word_count };
+    term_ids_.resize(term_ids_.size() + word_count);
+    term_freqs_.resize(term_freqs_.size() + word_count);
+}
+
+void ForwardIndex::RemoveDocument(int ordinal) {
+    dead_entry_count_ += ranges_[ordinal].word_count;
+    ranges_[ordinal] = {};
+}
+
+void ForwardIndex::RemapOrdinals(const std::vector<int>& new_ordinals, size_t ordinal_count) {
+    ForwardIndex remapped;
+    remapped.ranges_.resize(ordinal_count);
+    remapped.term_ids_.reserve(GetEntryCount() - dead_entry_count_);
+    remapped.term_freqs_.reserve(GetEntryCount() - dead_entry_count_);
+    for (size_t ordinal = 0; ordinal < new_ordinals.size() && ordinal < ranges_.size(); ++ordinal) {
+        const int new_ordinal = new_ordinals[ordinal];
+        if (new_ordinal == -1) {
+            continue;
+        }
+        const DocumentRange range = ranges_[ordinal];
+        remapped.ranges_[new_ordinal] = { remapped.term_ids_.size(), range.word_count };
+        for (size_t position = range.begin; position < range.begin + range.word_count; ++position) {
+            remapped.term_ids_.push_back(GetTermId(position));
+            remapped.term_freqs_.push_back(GetTermFreq(position));
+        }
+    }
+    *this = std::move(remapped);
+}
+
+size_t ForwardIndex::GetLiveBytes() const {
+    return (GetEntryCount() - dead_entry_count_) * ENTRY_BYTES;
+}
+
+size_t ForwardIndex::GetDeadBytes() const {
+    return dead_entry_count_ * ENTRY_BYTES;
+}
+
+void ForwardIndex::MakeOwned() {
+    if (borrowed_term_ids_ == nullptr) {
+        return;
+    }
+    term_ids_.assign(borrowed_term_ids_, borrowed_term_ids_ + borrowed_entry_count_);
+    term_freqs_.assign(borrowed_term_freqs_, borrowed_term_freqs_ + borrowed_entry_count_);
+    borrowed_term_ids_ = nullptr;
+    borrowed_term_freqs_ = nullptr;
+    borrowed_entry_count_ = 0;
+    borrowed_block_ = nullptr;
+}
+
+size_t WordFrequencies::count(std::string_view word) const {
+    size_t left = 0;
+    size_t right = size();
+    while (left < right) {
+        const size_t middle = left + (right - left) / 2;
+        if (GetWord(middle) < word) {
+            left = middle + 1;
+        }
+        else {
+            right = middle;
+        }
+    }
+    return left < size() && GetWord(left) == word ? 1 : 0;
+}
+
+bool operator==(const WordFrequencies& lhs, const WordFrequencies& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+bool operator!=(const WordFrequencies& lhs, const WordFrequencies& rhs) {
+    return !(lhs == rhs);
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "inverted_index.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Прямой индекс: номера слов документов в словаре инвертированного индекса и их частоты.
+// Слова документа занимают непрерывный участок общих массивов номеров и частот и
+// отсортированы по алфавиту. Участки удаленных документов остаются в массивах до уплотнения.
+// Массивы могут быть заимствованы из отображенного снимка: тогда они копируются
+// в собственную память перед первым выделением участка
+class ForwardIndex {
+public:
+    // Заимствует массивы номеров и частот слов из entry_count элементов без копирования.
+    // block - память, в которой они лежат, хранится, пока индекс на нее ссылается.
+    // Участки документов затем задаются SetDocument
+    void Borrow(std::shared_ptr<const char[]> block, const uint32_t* term_ids, const double* term_freqs,
+        size_t entry_count);
+
+    // Задает документу с номером ordinal участок из word_count слов, начиная с позиции begin
+    void SetDocument(int ordinal, size_t begin, size_t word_count);
+
+    // Выделяет документу с номером ordinal участок из word_count слов в конце массивов.
+    // Слова участка задаются SetWord, для разных документов - в том числе параллельно
+    void AllocateDocument(int ordinal, size_t word_count);
+
+    // Задает index-е по алфавиту слово документа с номером ordinal
+    void SetWord(int ordinal, size_t index, uint32_t term_id, double term_freq) {
+        const size_t position = ranges_[ordinal].begin + index;
+        term_ids_[position] = term_id;
+        term_freqs_[position] = term_freq;
+    }
+
+    // Участок документа с номером ordinal становится мертвым
+    void RemoveDocument(int ordinal);
+
+    // Переносит участки живых документов на номера new_ordinals[ordinal] без мертвых участков;
+    // -1 - номер удаленного документа. Номеров после переноса ordinal_count
+    void RemapOrdinals(const std::vector<int>& new_ordinals, size_t ordinal_count);
+
+    // Позиция первого слова документа в массивах и количество его слов
+    size_t GetDocumentBegin(int ordinal) const {
+        return ranges_[ordinal].begin;
+    }
+
+    size_t GetDocumentWordCount(int ordinal) const {
+        return ranges_[ordinal].word_count;
+    }
+
+    uint32_t GetTermId(size_t position) const {
+        return borrowed_term_ids_ != nullptr ? borrowed_term_ids_[position] : term_ids_[position];
+    }
+
+    double GetTermFreq(size_t position) const {
+        return borrowed_term_ids_ != nullptr ? borrowed_term_freqs_[position] : term_freqs_[position];
+    }
+
+    // Байты номеров и частот слов живых и удаленных документов
+    size_t GetLiveBytes() const;
+
+    size_t GetDeadBytes() const;
+
+private:
+    static constexpr size_t ENTRY_BYTES = sizeof(uint32_t) + sizeof(double);
+
+    struct DocumentRange {
+        size_t begin = 0;
+        size_t word_count = 0;
+    };
+
+    std::vector<uint32_t> term_ids_;
+    std::vector<double> term_freqs_;
+    std::vector<DocumentRange> ranges_;
+    size_t dead_entry_count_ = 0;
+    // Заимствованные массивы, используются вместо term_ids_ и term_freqs_, если не nullptr
+    const uint32_t* borrowed_term_ids_ = nullptr;
+    const double* borrowed_term_freqs_ = nullptr;
+    size_t borrowed_entry_count_ = 0;
+    std::shared_ptr<const char[]> borrowed_block_;
+
+    size_t GetEntryCount() const {
+        return borrowed_term_ids_ != nullptr ? borrowed_entry_count_ : term_ids_.size();
+    }
+
+    // Копирует заимствованные массивы в собственную память
+    void MakeOwned();
+};
+
+// Слова документа с частотами, по алфавиту: представление участка прямого индекса.
+// Действительно, пока документ не удален и индекс не уплотнен
+class WordFrequencies {
+public:
+    // Элементы - пары (слово, частота), возвращаемые по значению
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const WordFrequencies& words, size_t position)
+            : index_(words.index_)
+            , forward_index_(words.forward_index_)
+            , position_(position) {
+        }
+
+        value_type operator*() const {
+            return { index_->GetWord(forward_index_->GetTermId(position_)), forward_index_->GetTermFreq(position_) };
+        }
+
+        Iterator& operator++() {
+            ++position_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator result = *this;
+            ++position_;
+            return result;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return position_ == other.position_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return position_ != other.position_;
+        }
+
+    private:
+        const InvertedIndex* index_;
+        const ForwardIndex* forward_index_;
+        size_t position_;
+    };
+
+    // Пустой список слов
+    WordFrequencies() = default;
+
+    WordFrequencies(const InvertedIndex& index, const ForwardIndex& forward_index, int ordinal)
+        : index_(&index)
+        , forward_index_(&forward_index)
+        , begin_(forward_index.GetDocumentBegin(ordinal))
+        , end_(begin_ + forward_index.GetDocumentWordCount(ordinal)) {
+    }
+
+    Iterator begin() const {
+        return Iterator(*this, begin_);
+    }
+
+    Iterator end() const {
+        return Iterator(*this, end_);
+    }
+
+    size_t size() const {
+        return end_ - begin_;
+    }
+
+    bool empty() const {
+        return begin_ == end_;
+    }
+
+    // Номер index-го по алфавиту слова в словаре индекса
+    uint32_t GetTermId(size_t index) const {
+        return forward_index_->GetTermId(begin_ + index);
+    }
+
+    std::string_view GetWord(size_t index) const {
+        return index_->GetWord(GetTermId(index));
+    }
+
+    // 1, если слово есть в документе, иначе 0. Двоичный поиск по словам документа
+    size_t count(std::string_view word) const;
+
+private:
+    const InvertedIndex* index_ = nullptr;
+    const ForwardIndex* forward_index_ = nullptr;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+};
+
+// Совпадают слова и частоты
+bool operator==(const WordFrequencies& lhs, const WordFrequencies& rhs);
+
+bool operator!=(const WordFrequencies& lhs, const WordFrequencies& rhs);
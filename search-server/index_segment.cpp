@@ -0,0 +1,68 @@
+#include "index_segment.h"
+
+size_t IndexSegment::GetDocumentCount() const {
+    return document_ids.size();
+}
+
+void IndexSegment::AddDocument(int document_id, int rating, DocumentStatus status,
+    const std::vector<std::pair<std::string_view, double>>& word_freqs) {
+    const int ordinal = static_cast<int>(document_ids.size());
+    document_ids.push_back(document_id);
+    ratings.push_back(rating);
+    statuses.push_back(status);
+    for (const auto& [word, term_freq] : word_freqs) {
+        words.push_back(index.Add(word, ordinal, term_freq));
+        term_freqs.push_back(term_freq);
+    }
+    word_offsets.push_back(words.size());
+}
+
+SegmentMerge MergeIndexSegments(const std::vector<const IndexSegment*>& sources,
+    const std::vector<const std::vector<bool>*>& deleted) {
+    SegmentMerge result{ std::make_shared<IndexSegment>(), std::vector<std::vector<int>>(sources.size()) };
+    IndexSegment& merged = *result.merged;
+    for (size_t s = 0; s < sources.size(); ++s) {
+        const IndexSegment& source = *sources[s];
+        std::vector<int>& new_ordinals = result.new_ordinals[s];
+        new_ordinals.assign(source.GetDocumentCount(), -1);
+        for (size_t ordinal = 0; ordinal < source.GetDocumentCount(); ++ordinal) {
+            if ((*deleted[s])[ordinal]) {
+                continue;
+            }
+            new_ordinals[ordinal] = static_cast<int>(merged.GetDocumentCount());
+            merged.document_ids.push_back(source.document_ids[ordinal]);
+            merged.ratings.push_back(source.ratings[ordinal]);
+            merged.statuses.push_back(source.statuses[ordinal]);
+            for (size_t i = source.word_offsets[ordinal]; i < source.word_offsets[ordinal + 1]; ++i) {
+                merged.words.push_back(merged.index.Add(source.words[i], new_ordinals[ordinal], source.term_freqs[i]));
+                merged.term_freqs.push_back(source.term_freqs[i]);
+            }
+            merged.word_offsets.push_back(merged.words.size());
+        }
+    }
+    return result;
+}
+
+RelevanceAccumulator& GetSegmentAccumulator() {
+    thread_local RelevanceAccumulator accumulator;
+    return accumulator;
+}
+
+SearchServer::MyTuple MatchSegmentDocument(const IndexSegment& segment, int ordinal, const TextAnalyzer::Query& query) {
+    const auto words_begin = segment.words.begin() + segment.word_offsets[ordinal];
+    const auto words_end = segment.words.begin() + segment.word_offsets[ordinal + 1];
+    const DocumentStatus status = segment.statuses[ordinal];
+
+    std::vector<std::string_view> matched_words;
+    for (std::string_view word : query.minus_words) {
+        if (std::binary_search(words_begin, words_end, word)) {
+            return { matched_words, status };
+        }
+    }
+    for (std::string_view word : query.plus_words) {
+        if (std::binary_search(words_begin, words_end, word)) {
+            matched_words.push_back(word);
+        }
+    }
+    return { matched_words, status };
+}
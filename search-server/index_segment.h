@@ -0,0 +1,114 @@
+#pragma once
+#include "document.h"
+#include "inverted_index.h"
+#include "minus_word_filter.h"
+#include "posting_cursor.h"
+#include "relevance_accumulator.h"
+#include "search_server.h"
+#include "text_analyzer.h"
+#include "top_documents.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Сегмент индекса: часть документов сервера, которая не изменяется после построения.
+// Документы сегмента нумеруются порядковыми номерами с нуля в порядке добавления;
+// слова хранятся в арене инвертированного индекса сегмента.
+// Удаленные документы отмечаются вне сегмента и отбрасываются при слиянии сегментов
+struct IndexSegment {
+    InvertedIndex index;
+    std::vector<int> document_ids;
+    std::vector<int> ratings;
+    std::vector<DocumentStatus> statuses;
+    // Слова документа ordinal с частотами, отсортированные по словам:
+    // words[word_offsets[ordinal]] .. words[word_offsets[ordinal + 1] - 1]
+    std::vector<size_t> word_offsets{ 0 };
+    std::vector<std::string_view> words;
+    std::vector<double> term_freqs;
+
+    size_t GetDocumentCount() const;
+
+    // Добавляет документ со следующим порядковым номером
+    void AddDocument(int document_id, int rating, DocumentStatus status,
+        const std::vector<std::pair<std::string_view, double>>& word_freqs);
+};
+
+// Результат слияния: сегмент merged и новые номера документов исходных сегментов,
+// new_ordinals[s][ordinal] - номер документа ordinal сегмента s в merged или -1 для удаленного
+struct SegmentMerge {
+    std::shared_ptr<IndexSegment> merged;
+    std::vector<std::vector<int>> new_ordinals;
+};
+
+// Сливает сегменты sources по порядку, отбрасывая документы, отмеченные в deleted[s]
+SegmentMerge MergeIndexSegments(const std::vector<const IndexSegment*>& sources,
+    const std::vector<const std::vector<bool>*>& deleted);
+
+// Сегменты states, которые нужно слить: [first, last), пустой диапазон - сливать нечего.
+// Сливаются последние merge_factor сегментов одного уровня, а сегмент, в котором удалено
+// больше половины документов, переписывается отдельно.
+// Элементы states содержат поля segment (указатель на IndexSegment), deleted_count и level
+template <typename SegmentStates>
+std::pair<size_t, size_t> FindSegmentMergeRange(const SegmentStates& states, size_t merge_factor) {
+    if (states.size() >= merge_factor) {
+        const size_t first = states.size() - merge_factor;
+        const bool same_level = std::all_of(states.begin() + first, states.end(),
+            [&states, first](const auto& state) {
+                return state.level == states[first].level;
+            });
+        if (same_level) {
+            return { first, states.size() };
+        }
+    }
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (states[i].deleted_count * 2 > states[i].segment->GetDocumentCount()) {
+            return { i, i + 1 };
+        }
+    }
+    return { 0, 0 };
+}
+
+// Накопитель релевантности потока для поиска по сегментам
+RelevanceAccumulator& GetSegmentAccumulator();
+
+// Отбирает в top_documents документы сегмента, не отмеченные в deleted и подходящие под запрос.
+// inverse_document_freqs - IDF плюс-слов запроса, общие для всех сегментов сервера
+template <typename DocumentPredicate>
+void AddSegmentDocuments(const IndexSegment& segment, const std::vector<bool>& deleted,
+    const TextAnalyzer::Query& query, const std::vector<double>& inverse_document_freqs,
+    DocumentPredicate& document_predicate, TopDocuments& top_documents) {
+    RelevanceAccumulator& accumulator = GetSegmentAccumulator();
+    accumulator.Reset();
+    accumulator.Resize(segment.GetDocumentCount());
+
+    // Список документов каждого плюс-слова проходится вместе со списками минус-слов
+    MinusWordFilter minus_words(segment.index, query.minus_words);
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        const PostingList* postings = segment.index.Find(query.plus_words[i]);
+        if (postings == nullptr) {
+            continue;
+        }
+        minus_words.Rewind();
+        for (PostingCursor cursor(segment.index, *postings); cursor.GetOrdinal() != PostingCursor::END; cursor.Next()) {
+            const int ordinal = cursor.GetOrdinal();
+            if (deleted[ordinal] || minus_words.IsExcluded(ordinal)) {
+                continue;
+            }
+            if (document_predicate(segment.document_ids[ordinal], segment.statuses[ordinal], segment.ratings[ordinal])) {
+                accumulator.Add(ordinal, cursor.GetTermFreq() * inverse_document_freqs[i]);
+            }
+        }
+    }
+
+    accumulator.ForEach([&](int ordinal, double relevance) {
+        top_documents.Add({ segment.document_ids[ordinal], relevance, segment.ratings[ordinal] });
+    });
+    accumulator.Reset();
+}
+
+// Слова запроса, найденные в документе ordinal сегмента, как в SearchServer::MatchDocument
+SearchServer::MyTuple MatchSegmentDocument(const IndexSegment& segment, int ordinal, const TextAnalyzer::Query& query);
@@ -0,0 +1,409 @@
+#include "inverted_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+// Хеш слова для ячеек словаря снимка (FNV-1a): в отличие от std::hash,
+// не зависит от реализации стандартной библиотеки, записавшей снимок
+uint64_t HashDictionaryWord(std::string_view word) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : word) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+std::string_view InvertedIndex::Add(std::string_view word, int ordinal, double term_freq) {
+    const uint32_t term_id = FindOrInsertWord(word);
+    AddPosting(postings_[term_id], ordinal, term_freq);
+    return term_words_[term_id];
+}
+
+std::string_view InvertedIndex::Append(std::string_view word, const PostingList& postings) {
+    if (postings.empty()) {
+        return FindStoredWord(word);
+    }
+    const uint32_t term_id = FindOrInsertWord(word);
+    PostingList& word_postings = postings_[term_id];
+    MakeOwned(word_postings);
+    word_postings.max_term_freq = std::max(word_postings.max_term_freq,
+        *std::max_element(postings.term_freqs.begin(), postings.term_freqs.end()));
+
+    if (format_ == PostingsFormat::COMPRESSED) {
+        // Сжатый список дописывается по одному документу: перекодируется только последний блок
+        for (size_t i = 0; i < postings.size(); ++i) {
+            word_postings.compressed.Add(postings.ordinals[i], postings.term_freqs[i], inverse_word_counts_);
+        }
+        word_postings.log_document_freq = std::log(word_postings.size());
+        return term_words_[term_id];
+    }
+
+    if (!word_postings.empty() && word_postings.ordinals.back() >= postings.ordinals.front()) {
+        // Номера пересекаются с имеющимися - добавляем по одному
+        for (size_t i = 0; i < postings.size(); ++i) {
+            AddPosting(word_postings, postings.ordinals[i], postings.term_freqs[i]);
+        }
+        return term_words_[term_id];
+    }
+    word_postings.ordinals.insert(word_postings.ordinals.end(), postings.ordinals.begin(), postings.ordinals.end());
+    word_postings.term_freqs.insert(word_postings.term_freqs.end(), postings.term_freqs.begin(), postings.term_freqs.end());
+    word_postings.log_document_freq = std::log(word_postings.size());
+    return term_words_[term_id];
+}
+
+void InvertedIndex::Remove(std::string_view word, int ordinal) {
+    const uint32_t term_id = FindTermId(word);
+    if (term_id != NO_TERM_ID) {
+        Remove(term_id, ordinal);
+    }
+}
+
+void InvertedIndex::Remove(uint32_t term_id, int ordinal) {
+    PostingList& postings = postings_[term_id];
+    MakeOwned(postings);
+
+    if (format_ == PostingsFormat::COMPRESSED) {
+        postings.compressed.Remove(ordinal);
+        postings.log_document_freq = std::log(postings.size());
+        return;
+    }
+
+    auto it = std::lower_bound(postings.ordinals.begin(), postings.ordinals.end(), ordinal);
+    if (it == postings.ordinals.end() || *it != ordinal) {
+        return;
+    }
+    const auto pos = std::distance(postings.ordinals.begin(), it);
+    postings.ordinals.erase(it);
+    postings.term_freqs.erase(postings.term_freqs.begin() + pos);
+    postings.log_document_freq = std::log(postings.size());
+}
+
+void InvertedIndex::EraseWordIfEmpty(std::string_view word) {
+    const uint32_t term_id = FindTermId(word);
+    if (term_id != NO_TERM_ID) {
+        EraseIfEmpty(term_id);
+    }
+}
+
+void InvertedIndex::EraseIfEmpty(uint32_t term_id) {
+    if (!postings_[term_id].empty() || term_words_[term_id].empty()) {
+        return;
+    }
+    MakeDictionaryOwned();
+    const std::string_view stored_word = term_words_[term_id];
+    word_to_term_id_.Erase(stored_word);
+    words_.Release(stored_word);
+    term_words_[term_id] = {};
+    postings_[term_id] = {};
+    free_term_ids_.push_back(term_id);
+}
+
+const PostingList* InvertedIndex::Find(std::string_view word) const {
+    const uint32_t term_id = FindTermId(word);
+    return term_id == NO_TERM_ID ? nullptr : &postings_[term_id];
+}
+
+std::string_view InvertedIndex::FindStoredWord(std::string_view word) const {
+    const uint32_t term_id = FindTermId(word);
+    return term_id == NO_TERM_ID ? std::string_view{} : term_words_[term_id];
+}
+
+uint32_t InvertedIndex::FindTermId(std::string_view word) const {
+    if (mapped_slots_ != nullptr) {
+        // Линейное пробирование ограничено числом ячеек: ячейки снимка не проверяются при загрузке
+        const size_t mask = mapped_slot_count_ - 1;
+        size_t slot = HashDictionaryWord(word) & mask;
+        for (size_t probe = 0; probe < mapped_slot_count_ && mapped_slots_[slot] != 0; ++probe) {
+            const uint32_t term_id = mapped_slots_[slot] - 1;
+            if (term_id < term_words_.size() && term_words_[term_id] == word) {
+                return term_id;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return NO_TERM_ID;
+    }
+    const auto* entry = word_to_term_id_.FindEntry(word);
+    return entry == nullptr ? NO_TERM_ID : entry->value;
+}
+
+TermArena InvertedIndex::Compact() {
+    TermArena words;
+    StringHashMap<uint32_t> word_to_term_id;
+    word_to_term_id.Reserve(GetWordCount());
+    for (uint32_t term_id = 0; term_id < term_words_.size(); ++term_id) {
+        if (term_words_[term_id].empty()) {
+            continue;
+        }
+        PostingList& postings = postings_[term_id];
+        postings.ordinals.shrink_to_fit();
+        postings.term_freqs.shrink_to_fit();
+        postings.compressed.ShrinkToFit();
+        UpdateMaxTermFreq(postings);
+        // Номер слова сохраняется, меняется только ссылка на слово
+        term_words_[term_id] = words.Store(term_words_[term_id]);
+        word_to_term_id.Insert(term_words_[term_id], term_id);
+    }
+    word_to_term_id_ = std::move(word_to_term_id);
+    mapped_slots_ = nullptr;
+    std::swap(words_, words);
+    return words;
+}
+
+void InvertedIndex::RemapOrdinals(const std::vector<int>& new_ordinals) {
+    std::vector<double> inverse_word_counts;
+    for (size_t ordinal = 0; ordinal < new_ordinals.size(); ++ordinal) {
+        const int new_ordinal = new_ordinals[ordinal];
+        if (new_ordinal == -1) {
+            continue;
+        }
+        if (static_cast<size_t>(new_ordinal) >= inverse_word_counts.size()) {
+            inverse_word_counts.resize(new_ordinal + 1, 0.0);
+        }
+        inverse_word_counts[new_ordinal] = ordinal < inverse_word_counts_.size() ? inverse_word_counts_[ordinal] : 0.0;
+    }
+
+    std::vector<int> ordinals;
+    std::vector<double> term_freqs;
+    for (PostingList& postings : postings_) {
+        if (format_ == PostingsFormat::COMPRESSED) {
+            // Разности номеров меняются, поэтому сжатый список кодируется заново
+            postings.compressed.Decode(ordinals, term_freqs, inverse_word_counts_);
+            for (int& ordinal : ordinals) {
+                ordinal = new_ordinals[ordinal];
+            }
+            postings.compressed.Assign(ordinals, term_freqs, inverse_word_counts);
+            continue;
+        }
+        MakeOwned(postings);
+        for (int& ordinal : postings.ordinals) {
+            ordinal = new_ordinals[ordinal];
+        }
+    }
+    inverse_word_counts_ = std::move(inverse_word_counts);
+}
+
+void InvertedIndex::AdoptWords(std::shared_ptr<const char[]> block, size_t word_bytes) {
+    words_.Adopt(std::move(block), word_bytes);
+}
+
+uint32_t InvertedIndex::Restore(std::string_view stored_word, PostingList postings) {
+    postings.log_document_freq = std::log(postings.size());
+    postings.max_term_freq = postings.empty() ? 0.0
+        : *std::max_element(postings.GetTermFreqs(), postings.GetTermFreqs() + postings.size());
+    if (format_ == PostingsFormat::COMPRESSED) {
+        MakeOwned(postings);
+        postings.compressed.Assign(postings.ordinals, postings.term_freqs, inverse_word_counts_);
+        postings.ordinals = std::vector<int>();
+        postings.term_freqs = std::vector<double>();
+    }
+    const uint32_t term_id = AllocateTermId(stored_word);
+    postings.term_id = term_id;
+    postings_[term_id] = std::move(postings);
+    return term_id;
+}
+
+std::vector<uint32_t> InvertedIndex::BuildDictionarySlots() const {
+    size_t slot_count = 16;
+    while (GetWordCount() * 10 > slot_count * 7) {
+        slot_count *= 2;
+    }
+    std::vector<uint32_t> slots(slot_count, 0);
+    const size_t mask = slot_count - 1;
+    uint32_t index = 0;
+    for (const auto& [word, _] : *this) {
+        size_t slot = HashDictionaryWord(word) & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = ++index;
+    }
+    return slots;
+}
+
+void InvertedIndex::AdoptDictionary(std::shared_ptr<const char[]> block, const uint32_t* slots, size_t slot_count) {
+    word_to_term_id_ = {};
+    mapped_slots_ = slots;
+    mapped_slot_count_ = slot_count;
+    borrowed_block_ = std::move(block);
+}
+
+void InvertedIndex::SetDocumentWordCount(int ordinal, size_t word_count) {
+    if (static_cast<size_t>(ordinal) >= inverse_word_counts_.size()) {
+        inverse_word_counts_.resize(ordinal + 1, 0.0);
+    }
+    inverse_word_counts_[ordinal] = word_count == 0 ? 0.0 : 1.0 / word_count;
+}
+
+size_t InvertedIndex::GetDocumentWordCount(int ordinal) const {
+    if (static_cast<size_t>(ordinal) >= inverse_word_counts_.size() || inverse_word_counts_[ordinal] == 0.0) {
+        return 0;
+    }
+    return static_cast<size_t>(std::llround(1.0 / inverse_word_counts_[ordinal]));
+}
+
+void InvertedIndex::SetPostingsFormat(PostingsFormat format) {
+    if (format == format_) {
+        return;
+    }
+    for (PostingList& postings : postings_) {
+        if (format == PostingsFormat::COMPRESSED) {
+            MakeOwned(postings);
+            postings.compressed.Assign(postings.ordinals, postings.term_freqs, inverse_word_counts_);
+            postings.compressed.ShrinkToFit();
+            postings.ordinals = std::vector<int>();
+            postings.term_freqs = std::vector<double>();
+        }
+        else {
+            postings.compressed.Decode(postings.ordinals, postings.term_freqs, inverse_word_counts_);
+            postings.compressed = {};
+        }
+    }
+    format_ = format;
+}
+
+PostingsFormat InvertedIndex::GetPostingsFormat() const {
+    return format_;
+}
+
+const std::vector<double>& InvertedIndex::GetInverseWordCounts() const {
+    return inverse_word_counts_;
+}
+
+void InvertedIndex::Reserve(size_t word_count) {
+    word_to_term_id_.Reserve(word_count);
+    term_words_.reserve(word_count);
+    postings_.reserve(word_count);
+}
+
+InvertedIndex::Iterator InvertedIndex::begin() const {
+    return Iterator(*this, 0);
+}
+
+InvertedIndex::Iterator InvertedIndex::end() const {
+    return Iterator(*this, static_cast<uint32_t>(term_words_.size()));
+}
+
+size_t InvertedIndex::GetWordCount() const {
+    return term_words_.size() - free_term_ids_.size();
+}
+
+size_t InvertedIndex::GetPostingCount() const {
+    size_t count = 0;
+    for (const PostingList& postings : postings_) {
+        count += postings.size();
+    }
+    return count;
+}
+
+size_t InvertedIndex::GetMemoryUsage() const {
+    size_t bytes = sizeof(*this) + words_.GetStats().reserved_bytes + word_to_term_id_.GetMemoryUsage()
+        + postings_.capacity() * sizeof(PostingList);
+    for (const PostingList& postings : postings_) {
+        bytes += postings.ordinals.capacity() * sizeof(int);
+        bytes += postings.term_freqs.capacity() * sizeof(double);
+        bytes += postings.compressed.GetMemoryUsage();
+    }
+    bytes += inverse_word_counts_.capacity() * sizeof(double);
+    bytes += term_words_.capacity() * sizeof(std::string_view) + free_term_ids_.capacity() * sizeof(uint32_t);
+    return bytes;
+}
+
+ArenaStats InvertedIndex::GetArenaStats() const {
+    return words_.GetStats();
+}
+
+uint32_t InvertedIndex::InsertWord(std::string_view word) {
+    MakeDictionaryOwned();
+    const std::string_view stored_word = words_.Store(word);
+    const uint32_t term_id = AllocateTermId(stored_word);
+    word_to_term_id_.Insert(stored_word, term_id);
+    return term_id;
+}
+
+uint32_t InvertedIndex::FindOrInsertWord(std::string_view word) {
+    const uint32_t term_id = FindTermId(word);
+    return term_id == NO_TERM_ID ? InsertWord(word) : term_id;
+}
+
+uint32_t InvertedIndex::AllocateTermId(std::string_view stored_word) {
+    uint32_t term_id = 0;
+    if (free_term_ids_.empty()) {
+        term_id = static_cast<uint32_t>(term_words_.size());
+        term_words_.push_back(stored_word);
+        postings_.emplace_back();
+    }
+    else {
+        term_id = free_term_ids_.back();
+        free_term_ids_.pop_back();
+        term_words_[term_id] = stored_word;
+    }
+    postings_[term_id].term_id = term_id;
+    return term_id;
+}
+
+void InvertedIndex::AddPosting(PostingList& postings, int ordinal, double term_freq) {
+    MakeOwned(postings);
+    postings.max_term_freq = std::max(postings.max_term_freq, term_freq);
+
+    if (format_ == PostingsFormat::COMPRESSED) {
+        postings.compressed.Add(ordinal, term_freq, inverse_word_counts_);
+        postings.log_document_freq = std::log(postings.size());
+        return;
+    }
+
+    // Порядковые номера выдаются по возрастанию - обычно дописываем в конец
+    if (postings.empty() || postings.ordinals.back() < ordinal) {
+        postings.ordinals.push_back(ordinal);
+        postings.term_freqs.push_back(term_freq);
+        postings.log_document_freq = std::log(postings.size());
+        return;
+    }
+
+    auto it = std::lower_bound(postings.ordinals.begin(), postings.ordinals.end(), ordinal);
+    const auto pos = std::distance(postings.ordinals.begin(), it);
+    if (it != postings.ordinals.end() && *it == ordinal) {
+        postings.term_freqs[pos] += term_freq;
+        postings.max_term_freq = std::max(postings.max_term_freq, postings.term_freqs[pos]);
+        return;
+    }
+    postings.ordinals.insert(it, ordinal);
+    postings.term_freqs.insert(postings.term_freqs.begin() + pos, term_freq);
+    postings.log_document_freq = std::log(postings.size());
+}
+
+void InvertedIndex::MakeOwned(PostingList& postings) {
+    if (postings.borrowed_ordinals == nullptr) {
+        return;
+    }
+    postings.ordinals.assign(postings.borrowed_ordinals, postings.borrowed_ordinals + postings.borrowed_size);
+    postings.term_freqs.assign(postings.borrowed_term_freqs, postings.borrowed_term_freqs + postings.borrowed_size);
+    postings.borrowed_ordinals = nullptr;
+    postings.borrowed_term_freqs = nullptr;
+    postings.borrowed_size = 0;
+}
+
+void InvertedIndex::MakeDictionaryOwned() {
+    if (mapped_slots_ == nullptr) {
+        return;
+    }
+    word_to_term_id_.Reserve(term_words_.size());
+    for (uint32_t term_id = 0; term_id < term_words_.size(); ++term_id) {
+        if (!term_words_[term_id].empty()) {
+            word_to_term_id_.Insert(term_words_[term_id], term_id);
+        }
+    }
+    mapped_slots_ = nullptr;
+}
+
+void InvertedIndex::UpdateMaxTermFreq(PostingList& postings) const {
+    postings.max_term_freq = 0.0;
+    ForEachPosting(postings, [&postings](int, double term_freq) {
+        postings.max_term_freq = std::max(postings.max_term_freq, term_freq);
+    });
+}
@@ -0,0 +1,290 @@
+#pragma once
+
+#include "compressed_postings.h"
+#include "string_hash_map.h"
+#include "term_arena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Список документов, содержащих слово (структура массивов):
+// ordinals - порядковые номера документов в индексе, отсортированные по возрастанию;
+// term_freqs - частоты слова в соответствующих документах;
+// compressed - тот же список в сжатом виде, если индекс хранит списки сжатыми
+// (тогда ordinals и term_freqs пусты);
+// borrowed_ordinals, borrowed_term_freqs, borrowed_size - несжатый список в чужой памяти
+// (в отображенном снимке), если borrowed_ordinals не nullptr (тогда ordinals и term_freqs пусты).
+// Индекс копирует заимствованный список в ordinals и term_freqs перед первым изменением;
+// log_document_freq - логарифм количества документов со словом, поддерживается
+// при каждом изменении списка, чтобы IDF считался без вызова log при поиске;
+// max_term_freq - верхняя граница частот слова в списке для отсечения документов
+// при поиске лучших: растет при добавлении, уточняется при уплотнении индекса;
+// term_id - номер слова в словаре индекса
+struct PostingList {
+    std::vector<int> ordinals;
+    std::vector<double> term_freqs;
+    CompressedPostingList compressed;
+    const int* borrowed_ordinals = nullptr;
+    const double* borrowed_term_freqs = nullptr;
+    size_t borrowed_size = 0;
+    double log_document_freq = 0.0;
+    double max_term_freq = 0.0;
+    uint32_t term_id = 0;
+
+    size_t size() const {
+        return ordinals.size() + compressed.size() + borrowed_size;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    // Номера и частоты несжатого списка, собственного или заимствованного
+    const int* GetOrdinals() const {
+        return borrowed_ordinals != nullptr ? borrowed_ordinals : ordinals.data();
+    }
+
+    const double* GetTermFreqs() const {
+        return borrowed_ordinals != nullptr ? borrowed_term_freqs : term_freqs.data();
+    }
+};
+
+// Формат хранения списков документов в инвертированном индексе:
+// RAW - несжатые массивы номеров и частот;
+// COMPRESSED - CompressedPostingList, частоты восстанавливаются по количеству слов документов
+enum class PostingsFormat {
+    RAW,
+    COMPRESSED,
+};
+
+// Номер, которого нет ни у одного слова словаря
+const uint32_t NO_TERM_ID = UINT32_MAX;
+
+// Инвертированный индекс: словарь слов, каждому слову соответствует
+// непрерывный отсортированный список документов и частот.
+// Словарь - хеш-таблица с открытой адресацией из слова в номер, слова словаря хранятся
+// в собственной арене, каждое слово - один раз.
+// Каждому слову словаря выдается номер, который не меняется, пока слово есть
+// в словаре, в том числе при уплотнении. Номера удаленных слов выдаются повторно.
+// Списки документов хранятся в массиве по номерам слов, поэтому по номеру
+// список находится без хеширования слова
+class InvertedIndex {
+public:
+    // Обход словаря по возрастанию номеров слов: элементы - пары (слово, список документов),
+    // возвращаемые по значению
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string_view, const PostingList&>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const InvertedIndex& index, uint32_t term_id)
+            : index_(&index)
+            , term_id_(term_id) {
+            SkipFreeTermIds();
+        }
+
+        value_type operator*() const {
+            return { index_->term_words_[term_id_], index_->postings_[term_id_] };
+        }
+
+        Iterator& operator++() {
+            ++term_id_;
+            SkipFreeTermIds();
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return term_id_ == other.term_id_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return term_id_ != other.term_id_;
+        }
+
+    private:
+        // Свободные номера не имеют слова
+        void SkipFreeTermIds() {
+            while (term_id_ < index_->term_words_.size() && index_->term_words_[term_id_].empty()) {
+                ++term_id_;
+            }
+        }
+
+        const InvertedIndex* index_;
+        uint32_t term_id_;
+    };
+
+    // Добавляет документ с порядковым номером ordinal и частотой term_freq в список документов слова.
+    // Возвращает ссылку на хранимую в индексе копию слова
+    std::string_view Add(std::string_view word, int ordinal, double term_freq);
+
+    // Добавляет в список документов слова документы из postings.
+    // Используется при пакетном добавлении: номера postings обычно больше имеющихся
+    std::string_view Append(std::string_view word, const PostingList& postings);
+
+    // Удаляет документ с порядковым номером ordinal из списка документов слова.
+    // Не изменяет словарь, поэтому допускает параллельные вызовы для разных слов
+    void Remove(std::string_view word, int ordinal);
+
+    // То же для слова с номером term_id: список берется из массива по номеру, без поиска в словаре
+    void Remove(uint32_t term_id, int ordinal);
+
+    // Удаляет слово из словаря, если в нем не осталось документов.
+    // Память слова возвращается при следующем уплотнении
+    void EraseWordIfEmpty(std::string_view word);
+
+    // То же для слова с номером term_id. Пустота списка проверяется по номеру, словарь
+    // ищется только при удалении слова. После удаления слова номер становится свободным
+    void EraseIfEmpty(uint32_t term_id);
+
+    // Возвращает список документов слова или nullptr, если слова нет в словаре
+    const PostingList* Find(std::string_view word) const;
+
+    // Возвращает хранимую в индексе копию слова или пустую строку, если слова нет в словаре
+    std::string_view FindStoredWord(std::string_view word) const;
+
+    // Возвращает номер слова или NO_TERM_ID, если слова нет в словаре
+    uint32_t FindTermId(std::string_view word) const;
+
+    // Хранимое в индексе слово с номером term_id из словаря
+    std::string_view GetWord(uint32_t term_id) const {
+        return term_words_[term_id];
+    }
+
+    // Переносит используемые слова в новую арену и освобождает лишнюю память списков документов.
+    // Возвращает старую арену: ее память нужна, пока внешние ссылки на слова не заменены на новые
+    TermArena Compact();
+
+    // Заменяет порядковые номера документов: ordinal -> new_ordinals[ordinal].
+    // Новые номера должны сохранять порядок старых
+    void RemapOrdinals(const std::vector<int>& new_ordinals);
+
+    // Принимает блок памяти с уже записанными словами суммарной длиной word_bytes
+    // (например, из снимка индекса). Слова блока используются без копирования
+    void AdoptWords(std::shared_ptr<const char[]> block, size_t word_bytes);
+
+    // Загрузка из снимка. Добавляет слово со списком документов (в том числе заимствованным)
+    // под следующим по порядку номером, не изменяя словарь: после всех слов словарь
+    // принимается AdoptDictionary. stored_word должно лежать в памяти, переданной в AdoptWords
+    uint32_t Restore(std::string_view stored_word, PostingList postings);
+
+    // Ячейки хеш-таблицы словаря для снимка: слово с i-м по порядку обхода номером лежит
+    // в ячейке со значением i + 1, пустые ячейки - 0. Количество ячеек - степень двойки
+    std::vector<uint32_t> BuildDictionarySlots() const;
+
+    // Принимает ячейки BuildDictionarySlots для слов, добавленных Restore. Ячейки не копируются,
+    // словарь ищется по ним, пока в него не добавлено или из него не удалено слово.
+    // block - память снимка с ячейками и заимствованными списками документов,
+    // хранится, пока индекс на нее ссылается
+    void AdoptDictionary(std::shared_ptr<const char[]> block, const uint32_t* slots, size_t slot_count);
+
+    // Запоминает количество слов документа (без стоп-слов) для восстановления частот
+    // сжатых списков. Вызывается до добавления документа в списки слов
+    void SetDocumentWordCount(int ordinal, size_t word_count);
+
+    size_t GetDocumentWordCount(int ordinal) const;
+
+    // Переводит все списки документов в формат format
+    void SetPostingsFormat(PostingsFormat format);
+
+    PostingsFormat GetPostingsFormat() const;
+
+    // Вызывает callback(ordinal, term_freq) для документов списка по возрастанию номеров
+    template <typename Callback>
+    void ForEachPosting(const PostingList& postings, Callback callback) const;
+
+    // Вызывает callback(ordinal) для документов списка по возрастанию номеров
+    template <typename Callback>
+    void ForEachOrdinal(const PostingList& postings, Callback callback) const;
+
+    // 1 / количество слов документа по порядковым номерам, по ним восстанавливаются частоты сжатых списков
+    const std::vector<double>& GetInverseWordCounts() const;
+
+    // Резервирует место в словаре для word_count слов
+    void Reserve(size_t word_count);
+
+    Iterator begin() const;
+
+    Iterator end() const;
+
+    // Возвращает количество слов в словаре
+    size_t GetWordCount() const;
+
+    // Возвращает суммарное количество пар (документ, частота)
+    size_t GetPostingCount() const;
+
+    // Оценка занимаемой индексом памяти в байтах
+    size_t GetMemoryUsage() const;
+
+    ArenaStats GetArenaStats() const;
+
+private:
+    StringHashMap<uint32_t> word_to_term_id_;
+    // Ячейки словаря из снимка, используются вместо word_to_term_id_, если не nullptr
+    const uint32_t* mapped_slots_ = nullptr;
+    size_t mapped_slot_count_ = 0;
+    // Память снимка, на которую ссылаются ячейки словаря и заимствованные списки
+    std::shared_ptr<const char[]> borrowed_block_;
+    // Список документов для каждого номера слова, пустой для свободных номеров
+    std::vector<PostingList> postings_;
+    TermArena words_;
+    PostingsFormat format_ = PostingsFormat::RAW;
+    // 1 / количество слов документа для каждого порядкового номера, 0 для пустых документов
+    std::vector<double> inverse_word_counts_;
+    // Слово для каждого номера, пустая строка для свободных номеров
+    std::vector<std::string_view> term_words_;
+    std::vector<uint32_t> free_term_ids_;
+
+    // Добавляет в словарь отсутствующее в нем слово с пустым списком документов, возвращает номер слова
+    uint32_t InsertWord(std::string_view word);
+
+    // Возвращает номер слова, добавляя слово в словарь при его отсутствии
+    uint32_t FindOrInsertWord(std::string_view word);
+
+    // Выдает номер слову stored_word с пустым списком документов
+    uint32_t AllocateTermId(std::string_view stored_word);
+
+    // Добавляет документ в список документов postings
+    void AddPosting(PostingList& postings, int ordinal, double term_freq);
+
+    // Копирует заимствованный список в собственную память перед его изменением
+    static void MakeOwned(PostingList& postings);
+
+    // Строит word_to_term_id_ вместо ячеек словаря из снимка перед изменением словаря
+    void MakeDictionaryOwned();
+
+    // Пересчитывает max_term_freq по текущим документам списка
+    void UpdateMaxTermFreq(PostingList& postings) const;
+};
+
+template <typename Callback>
+void InvertedIndex::ForEachPosting(const PostingList& postings, Callback callback) const {
+    if (format_ == PostingsFormat::COMPRESSED) {
+        postings.compressed.ForEach(inverse_word_counts_, callback);
+        return;
+    }
+    const int* ordinals = postings.GetOrdinals();
+    const double* term_freqs = postings.GetTermFreqs();
+    for (size_t i = 0; i < postings.size(); ++i) {
+        callback(ordinals[i], term_freqs[i]);
+    }
+}
+
+template <typename Callback>
+void InvertedIndex::ForEachOrdinal(const PostingList& postings, Callback callback) const {
+    if (format_ == PostingsFormat::COMPRESSED) {
+        postings.compressed.ForEachOrdinal(callback);
+        return;
+    }
+    const int* ordinals = postings.GetOrdinals();
+    for (size_t i = 0; i < postings.size(); ++i) {
+        callback(ordinals[i]);
+    }
+}
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <chrono>
 #include <string>
+#include <string_view>
 
 #define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
 #define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
@@ -14,11 +15,11 @@
 
 class LogDuration {
 public:
-	LogDuration(const std::string& id)
+	LogDuration(std::string_view id)
 		: id_(id) {
 	}
 	
-	LogDuration(const std::string& id, std::ostream& os)
+	LogDuration(std::string_view id, std::ostream& os)
 		: id_(id)
 		, out_(os){
 	}
@@ -31,7 +32,7 @@ public:
 
 		const auto end_time = Clock::now();
 		const auto dur = end_time - start_time_;
-		out_ << "Operation time : "s
+		out_ << id_ << ": "s
 			<< duration_cast<milliseconds>(dur).count() << " ms"s << std::endl;
 	}
 private:
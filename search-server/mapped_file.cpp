@@ -0,0 +1,64 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAS_MMAP 1
+#endif
+
+using namespace std::string_literals;
+
+#ifdef HAS_MMAP
+
+MappedFile MapFileForReading(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file "s + path);
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read size of file "s + path);
+    }
+    const size_t size = static_cast<size_t>(file_stat.st_size);
+    if (size == 0) {
+        close(fd);
+        return {};
+    }
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // Отображение остается действительным после закрытия дескриптора
+    close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Cannot map file "s + path);
+    }
+    MappedFile file;
+    file.data = std::shared_ptr<const char[]>(static_cast<const char*>(address),
+        [size](const char* data) {
+            munmap(const_cast<char*>(data), size);
+        });
+    file.size = size;
+    return file;
+}
+
+#else
+
+MappedFile MapFileForReading(const std::string& path) {
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+    if (!input) {
+        throw std::runtime_error("Cannot open file "s + path);
+    }
+    const size_t size = static_cast<size_t>(input.tellg());
+    std::shared_ptr<char[]> data(new char[size]);
+    input.seekg(0);
+    if (!input.read(data.get(), size)) {
+        throw std::runtime_error("Cannot read file "s + path);
+    }
+    return { std::move(data), size };
+}
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Файл, отображенный в память только для чтения.
+// Отображение живет, пока жива хотя бы одна копия data
+// (или указатель, созданный из data конструктором псевдонима shared_ptr)
+struct MappedFile {
+    std::shared_ptr<const char[]> data;
+    size_t size = 0;
+};
+
+// Отображает файл в память. Если отображение недоступно, файл читается в память целиком.
+// Выбрасывает std::runtime_error, если файл не удалось открыть
+MappedFile MapFileForReading(const std::string& path);
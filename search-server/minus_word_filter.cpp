@@ -0,0 +1,39 @@
+#include "minus_word_filter.h"
+
+#include <algorithm>
+
+MinusWordFilter::MinusWordFilter(const InvertedIndex& index, const std::vector<std::string_view>& minus_words) {
+    cursors_.reserve(minus_words.size());
+    for (std::string_view word : minus_words) {
+        const PostingList* postings = index.Find(word);
+        if (postings != nullptr) {
+            cursors_.emplace_back(index, *postings);
+        }
+    }
+    UpdateNextOrdinal();
+}
+
+bool MinusWordFilter::IsExcluded(int ordinal) {
+    if (ordinal < next_ordinal_) {
+        return false;
+    }
+    for (PostingCursor& cursor : cursors_) {
+        cursor.Advance(ordinal);
+    }
+    UpdateNextOrdinal();
+    return next_ordinal_ == ordinal;
+}
+
+void MinusWordFilter::Rewind() {
+    for (PostingCursor& cursor : cursors_) {
+        cursor.Rewind();
+    }
+    UpdateNextOrdinal();
+}
+
+void MinusWordFilter::UpdateNextOrdinal() {
+    next_ordinal_ = PostingCursor::END;
+    for (const PostingCursor& cursor : cursors_) {
+        next_ordinal_ = std::min(next_ordinal_, cursor.GetOrdinal());
+    }
+}
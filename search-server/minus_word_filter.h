@@ -0,0 +1,31 @@
+#pragma once
+
+#include "inverted_index.h"
+#include "posting_cursor.h"
+
+#include <string_view>
+#include <vector>
+
+// Проверка документов на минус-слова запроса без построения множества исключенных документов.
+// Документы проверяются по возрастанию номеров, курсоры списков минус-слов при этом
+// продвигаются до проверяемого номера с пропуском документов между ними.
+// Пока номер меньше ближайшего документа под курсорами, проверка не трогает курсоры
+class MinusWordFilter {
+public:
+    // Курсоры по спискам документов минус-слов из index. Индекс должен жить дольше фильтра
+    MinusWordFilter(const InvertedIndex& index, const std::vector<std::string_view>& minus_words);
+
+    // Возвращает true, если документ содержит минус-слово.
+    // Номера в последовательных вызовах не должны убывать до вызова Rewind
+    bool IsExcluded(int ordinal);
+
+    // Возвращает курсоры к началу списков для нового прохода по документам
+    void Rewind();
+
+private:
+    std::vector<PostingCursor> cursors_;
+    // Наименьший номер документа под курсорами
+    int next_ordinal_ = PostingCursor::END;
+
+    void UpdateNextOrdinal();
+};
@@ -0,0 +1,93 @@
+#include "posting_cursor.h"
+
+#include <algorithm>
+
+PostingCursor::PostingCursor(const InvertedIndex& index, const PostingList& postings)
+    : postings_(&postings) {
+    if (index.GetPostingsFormat() == PostingsFormat::COMPRESSED) {
+        inverse_word_counts_ = &index.GetInverseWordCounts();
+        block_ordinals_.resize(CompressedPostingList::BLOCK_SIZE);
+        block_term_freqs_.resize(CompressedPostingList::BLOCK_SIZE);
+    }
+    Rewind();
+}
+
+double PostingCursor::GetTermFreq() {
+    if (inverse_word_counts_ == nullptr) {
+        return postings_->GetTermFreqs()[position_];
+    }
+    if (!block_term_freqs_decoded_) {
+        postings_->compressed.DecodeBlockTermFreqs(block_, block_ordinals_.data(), block_term_freqs_.data(),
+            *inverse_word_counts_);
+        block_term_freqs_decoded_ = true;
+    }
+    return block_term_freqs_[position_];
+}
+
+void PostingCursor::Next() {
+    if (ordinal_ == END) {
+        return;
+    }
+    if (inverse_word_counts_ == nullptr) {
+        ordinal_ = ++position_ < postings_->size() ? postings_->GetOrdinals()[position_] : END;
+        return;
+    }
+    if (++position_ < block_size_) {
+        ordinal_ = block_ordinals_[position_];
+        return;
+    }
+    LoadBlock(block_ + 1);
+}
+
+void PostingCursor::Advance(int ordinal) {
+    if (ordinal_ >= ordinal) {
+        return;
+    }
+    if (inverse_word_counts_ == nullptr) {
+        // Экспоненциальный поиск: искомый документ обычно недалеко от текущего
+        const int* ordinals = postings_->GetOrdinals();
+        const size_t size = postings_->size();
+        size_t low = position_;
+        size_t step = 1;
+        while (low + step < size && ordinals[low + step] < ordinal) {
+            low += step;
+            step *= 2;
+        }
+        const size_t high = std::min(low + step + 1, size);
+        position_ = std::lower_bound(ordinals + low + 1, ordinals + high, ordinal) - ordinals;
+        ordinal_ = position_ < size ? ordinals[position_] : END;
+        return;
+    }
+
+    const CompressedPostingList& compressed = postings_->compressed;
+    if (ordinal > compressed.GetBlockLastOrdinal(block_)) {
+        LoadBlock(compressed.FindBlock(ordinal, block_ + 1));
+        if (ordinal_ == END) {
+            return;
+        }
+    }
+    position_ = std::lower_bound(block_ordinals_.begin() + position_, block_ordinals_.begin() + block_size_, ordinal)
+        - block_ordinals_.begin();
+    ordinal_ = block_ordinals_[position_];
+}
+
+void PostingCursor::Rewind() {
+    if (inverse_word_counts_ == nullptr) {
+        position_ = 0;
+        ordinal_ = postings_->empty() ? END : postings_->GetOrdinals()[0];
+        return;
+    }
+    LoadBlock(0);
+}
+
+void PostingCursor::LoadBlock(size_t block) {
+    block_ = block;
+    if (block == postings_->compressed.GetBlockCount()) {
+        ordinal_ = END;
+        return;
+    }
+    block_size_ = postings_->compressed.DecodeBlockOrdinals(block, block_ordinals_.data());
+    block_term_freqs_decoded_ = false;
+    position_ = 0;
+    ordinal_ = block_ordinals_[0];
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "inverted_index.h"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Курсор по списку документов слова для обработки запроса по документам:
+// документы перебираются по возрастанию порядковых номеров, а Advance пропускает
+// документы с меньшими номерами. В несжатом списке пропуск - экспоненциальный поиск,
+// в сжатом - поиск по границам блоков без распаковки пропущенных блоков.
+// Частоты сжатого блока распаковываются только при первом обращении к ним
+class PostingCursor {
+public:
+    // Номер документа курсора, дошедшего до конца списка
+    static constexpr int END = std::numeric_limits<int>::max();
+
+    // Курсор на первом документе списка. Список и индекс должны жить дольше курсора
+    PostingCursor(const InvertedIndex& index, const PostingList& postings);
+
+    // Номер текущего документа или END
+    int GetOrdinal() const {
+        return ordinal_;
+    }
+
+    // Частота слова в текущем документе
+    double GetTermFreq();
+
+    // Переходит к следующему документу
+    void Next();
+
+    // Переходит к первому документу с номером не меньше ordinal
+    void Advance(int ordinal);
+
+    // Возвращает курсор к первому документу списка
+    void Rewind();
+
+private:
+    const PostingList* postings_;
+    // Для сжатого списка - 1 / количество слов документов, иначе nullptr
+    const std::vector<double>* inverse_word_counts_ = nullptr;
+    int ordinal_ = END;
+    // Позиция в несжатом списке или в распакованном блоке
+    size_t position_ = 0;
+
+    // Распакованный блок сжатого списка
+    size_t block_ = 0;
+    size_t block_size_ = 0;
+    bool block_term_freqs_decoded_ = false;
+    std::vector<int> block_ordinals_;
+    std::vector<double> block_term_freqs_;
+
+    // Распаковывает номера блока block и ставит курсор на его первый документ
+    void LoadBlock(size_t block);
+};
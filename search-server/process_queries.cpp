@@ -3,22 +3,135 @@
 #include "search_server.h"
 
 #include <algorithm>
-#include <execution>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
+namespace {
+
+// Запросы в обработке хранятся в кольцевом буфере: запрос с номером n занимает
+// ячейку n % slots_.size(), пока его результат не передан получателю.
+// Вызывающий поток читает запросы и передает результаты, поиск выполняется задачами
+// в пуле потоков сервера
+class QueryPipeline {
+public:
+    QueryPipeline(const SearchServer& search_server, size_t max_in_flight)
+        : search_server_(search_server)
+        , thread_pool_(search_server.GetThreadPool())
+        , slots_(std::max<size_t>(1, max_in_flight)) {
+    }
+
+    QueryPipeline(const QueryPipeline&) = delete;
+    QueryPipeline& operator=(const QueryPipeline&) = delete;
+
+    // Задачи ссылаются на ячейки, поэтому ждем их завершения и при исключении.
+    // Process не выбрасывает исключений, поэтому Wait их не передает
+    ~QueryPipeline() {
+        thread_pool_.Wait(tasks_);
+    }
+
+    void Run(const QuerySource& source, const QueryResultConsumer& consumer) {
+        std::string query;
+        bool has_queries = true;
+        while (true) {
+            // Читаем запросы, пока есть свободные ячейки
+            while (has_queries && read_count_ - delivered_count_ < slots_.size()) {
+                if (!source(query)) {
+                    has_queries = false;
+                    break;
+                }
+                const uint64_t number = read_count_;
+                slots_[number % slots_.size()].query.swap(query);
+                ++read_count_;
+                thread_pool_.Submit(tasks_, [this, number] { Process(number); });
+            }
+            if (delivered_count_ == read_count_) {
+                break;
+            }
+
+            // Ждем результат самого раннего запроса, остальные продолжают обрабатываться
+            Slot& slot = slots_[delivered_count_ % slots_.size()];
+            WaitUntil([&slot] { return slot.is_ready; });
+            if (slot.error) {
+                std::rethrow_exception(slot.error);
+            }
+            std::vector<Document> documents = std::move(slot.documents);
+            slot.is_ready = false;
+            ++delivered_count_;
+            consumer(std::move(documents));
+        }
+    }
+
+private:
+    struct Slot {
+        std::string query;
+        std::vector<Document> documents;
+        std::exception_ptr error;
+        bool is_ready = false;
+    };
+
+    const SearchServer& search_server_;
+    ThreadPool& thread_pool_;
+    ThreadPool::TaskGroup tasks_;
+    std::vector<Slot> slots_;
+    std::mutex mutex_;
+    std::condition_variable result_ready_;
+    // Номера запросов: прочитанных из источника и переданных получателю
+    uint64_t read_count_ = 0;
+    uint64_t delivered_count_ = 0;
+
+    void Process(uint64_t number) {
+        // Ячейка не освобождается, пока результат не передан, поэтому читается без блокировки
+        Slot& slot = slots_[number % slots_.size()];
+        try {
+            slot.documents = search_server_.FindTopDocuments(slot.query);
+        }
+        catch (...) {
+            slot.error = std::current_exception();
+        }
+        std::lock_guard guard(mutex_);
+        slot.is_ready = true;
+        result_ready_.notify_all();
+    }
+
+    // Ожидающий поток сам выполняет задачи пула. Если очереди пусты, оставшиеся
+    // задачи уже выполняются другими потоками и можно спать до их завершения
+    template <typename Condition>
+    void WaitUntil(Condition condition) {
+        while (true) {
+            {
+                std::lock_guard guard(mutex_);
+                if (condition()) {
+                    return;
+                }
+            }
+            if (thread_pool_.RunPendingTask()) {
+                continue;
+            }
+            std::unique_lock lock(mutex_);
+            result_ready_.wait(lock, condition);
+            return;
+        }
+    }
+};
+
+} // namespace
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries) {
     
     std::vector<std::vector<Document>> finded_documents(queries.size());
     
-    if (!queries.empty()) {
-        std::transform(std::execution::par,
-            queries.begin(), queries.end(), finded_documents.begin(),
-            [&search_server](const std::string& query) { return search_server.FindTopDocuments(query); }
-        );
-    }
+    // Запросы выполняются задачами пула потоков сервера
+    search_server.GetThreadPool().ParallelFor(queries.size(),
+        [&](size_t i) {
+            finded_documents[i] = search_server.FindTopDocuments(queries[i]);
+        });
     return finded_documents;
 }
 
@@ -26,14 +139,35 @@ std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server, 
     const std::vector<std::string>& queries){
     
-    const std::vector<std::vector<Document>> finded_documents = ProcessQueries(search_server, queries);
-    
-    std::vector<Document>documents;
-    for (const auto& docs : finded_documents) {
-        for (const auto& doc : docs) {
-            documents.push_back(doc);
-        }
-    }
+    // Результаты дописываются по мере готовности, без промежуточного вектора результатов
+    std::vector<Document> documents;
+    documents.reserve(queries.size() * MAX_RESULT_DOCUMENT_COUNT);
+    size_t next_query = 0;
+    ProcessQueriesStream(search_server,
+        [&queries, &next_query](std::string& query) {
+            if (next_query == queries.size()) {
+                return false;
+            }
+            query = queries[next_query++];
+            return true;
+        },
+        [&documents](std::vector<Document> query_documents) {
+            documents.insert(documents.end(), query_documents.begin(), query_documents.end());
+        });
     return documents;
+}
 
-}
\ No newline at end of file
+void ProcessQueriesStream(const SearchServer& search_server, const QuerySource& source,
+    const QueryResultConsumer& consumer, size_t max_in_flight) {
+    QueryPipeline pipeline(search_server, max_in_flight);
+    pipeline.Run(source, consumer);
+}
+
+void ProcessQueriesStream(const SearchServer& search_server, std::istream& input,
+    const QueryResultConsumer& consumer, size_t max_in_flight) {
+    ProcessQueriesStream(search_server,
+        [&input](std::string& query) {
+            return static_cast<bool>(std::getline(input, query));
+        },
+        consumer, max_in_flight);
+}
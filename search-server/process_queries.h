@@ -2,6 +2,9 @@
 #include "document.h"
 #include "search_server.h"
 
+#include <cstddef>
+#include <functional>
+#include <istream>
 #include <vector>
 #include <string>
 
@@ -11,4 +14,30 @@ std::vector<std::vector<Document>> ProcessQueries(
 
 std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries);
\ No newline at end of file
+    const std::vector<std::string>& queries);
+
+// Источник запросов: записывает следующий запрос в query и возвращает true
+// или возвращает false, если запросы закончились
+using QuerySource = std::function<bool(std::string& query)>;
+
+// Получатель результатов: вызывается для каждого запроса в порядке их получения из источника
+using QueryResultConsumer = std::function<void(std::vector<Document> documents)>;
+
+// Количество запросов в обработке по умолчанию
+const size_t DEFAULT_MAX_QUERIES_IN_FLIGHT = 1024;
+
+// Потоковая обработка запросов: задачи в пуле потоков сервера выполняют FindTopDocuments
+// для запросов из источника, а результаты передаются получателю в вызывающем потоке в исходном порядке.
+// Источник и получатель вызываются только из вызывающего потока.
+// Одновременно в обработке находится не более max_in_flight запросов: пока получатель
+// не принял результат самого раннего из них, новые запросы из источника не читаются,
+// поэтому память не зависит от количества запросов.
+// Пока результат не готов, вызывающий поток сам выполняет задачи пула. Исключение запроса, источника или получателя
+// останавливает обработку и передается вызывающему; результаты предыдущих запросов
+// к этому моменту уже переданы получателю
+void ProcessQueriesStream(const SearchServer& search_server, const QuerySource& source,
+    const QueryResultConsumer& consumer, size_t max_in_flight = DEFAULT_MAX_QUERIES_IN_FLIGHT);
+
+// Запросы читаются из input по одному на строку
+void ProcessQueriesStream(const SearchServer& search_server, std::istream& input,
+    const QueryResultConsumer& consumer, size_t max_in_flight = DEFAULT_MAX_QUERIES_IN_FLIGHT);
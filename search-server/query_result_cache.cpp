@@ -0,0 +1,84 @@
+#include "query_result_cache.h"
+
+#include <functional>
+
+QueryResultCache::QueryResultCache(const QueryResultCache& other) {
+    SetCapacity(other.capacity_);
+}
+
+QueryResultCache& QueryResultCache::operator=(const QueryResultCache& other) {
+    if (this != &other) {
+        SetCapacity(other.capacity_);
+        hits_ = 0;
+        misses_ = 0;
+    }
+    return *this;
+}
+
+void QueryResultCache::SetCapacity(size_t capacity) {
+    capacity_ = capacity;
+    shard_capacity_ = (capacity + SHARD_COUNT - 1) / SHARD_COUNT;
+    for (Shard& shard : shards_) {
+        std::lock_guard guard(shard.mutex);
+        shard.key_to_entry.clear();
+        shard.entries.clear();
+    }
+}
+
+size_t QueryResultCache::GetCapacity() const {
+    return capacity_;
+}
+
+bool QueryResultCache::Find(std::string_view key, uint64_t generation, std::vector<Document>& documents) {
+    Shard& shard = GetShard(key);
+    std::lock_guard guard(shard.mutex);
+    const auto it = shard.key_to_entry.find(key);
+    if (it == shard.key_to_entry.end()) {
+        ++misses_;
+        return false;
+    }
+    const auto entry = it->second;
+    if (entry->generation != generation) {
+        // Результат получен до изменения индекса
+        shard.key_to_entry.erase(it);
+        shard.entries.erase(entry);
+        ++misses_;
+        return false;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, entry);
+    documents = entry->documents;
+    ++hits_;
+    return true;
+}
+
+void QueryResultCache::Insert(std::string_view key, uint64_t generation, const std::vector<Document>& documents) {
+    Shard& shard = GetShard(key);
+    std::lock_guard guard(shard.mutex);
+    const auto it = shard.key_to_entry.find(key);
+    if (it != shard.key_to_entry.end()) {
+        // Результат мог вычислить параллельный запрос с тем же ключом
+        it->second->generation = generation;
+        it->second->documents = documents;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+    shard.entries.push_front({ std::string(key), generation, documents });
+    shard.key_to_entry.emplace(shard.entries.front().key, shard.entries.begin());
+    if (shard.entries.size() > shard_capacity_) {
+        shard.key_to_entry.erase(shard.entries.back().key);
+        shard.entries.pop_back();
+    }
+}
+
+QueryResultCache::Stats QueryResultCache::GetStats() const {
+    size_t size = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard guard(shard.mutex);
+        size += shard.entries.size();
+    }
+    return { hits_, misses_, size };
+}
+
+QueryResultCache::Shard& QueryResultCache::GetShard(std::string_view key) {
+    return shards_[std::hash<std::string_view>{}(key) % SHARD_COUNT];
+}
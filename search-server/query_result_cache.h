@@ -0,0 +1,75 @@
+#pragma once
+#include "document.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Кеш результатов поиска с вытеснением давно не использованных записей (LRU).
+// Записи распределены по частям с собственными блокировками, поэтому параллельные
+// запросы блокируют друг друга, только попадая в одну часть.
+// Запись хранит поколение индекса, для которого получен результат: после изменения
+// индекса запись устаревает и удаляется при следующем обращении к ней.
+// Копия кеша пуста и имеет ту же емкость
+class QueryResultCache {
+public:
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t size;
+    };
+
+    QueryResultCache() = default;
+
+    QueryResultCache(const QueryResultCache& other);
+    QueryResultCache& operator=(const QueryResultCache& other);
+
+    // Емкость 0 выключает кеш. Емкость делится поровну между частями с округлением вверх.
+    // Изменение емкости очищает кеш
+    void SetCapacity(size_t capacity);
+
+    size_t GetCapacity() const;
+
+    bool IsEnabled() const {
+        return capacity_ > 0;
+    }
+
+    // Копирует в documents результат для ключа, полученный в поколении индекса generation.
+    // Возвращает false, если такого результата нет
+    bool Find(std::string_view key, uint64_t generation, std::vector<Document>& documents);
+
+    void Insert(std::string_view key, uint64_t generation, const std::vector<Document>& documents);
+
+    Stats GetStats() const;
+
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        std::vector<Document> documents;
+    };
+
+    // Часть кеша: записи от недавно использованных к давно использованным
+    // и словарь с ключами, ссылающимися на строки записей
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> key_to_entry;
+    };
+
+    size_t capacity_ = 0;
+    size_t shard_capacity_ = 0;
+    std::vector<Shard> shards_ = std::vector<Shard>(SHARD_COUNT);
+    std::atomic<size_t> hits_{ 0 };
+    std::atomic<size_t> misses_{ 0 };
+
+    Shard& GetShard(std::string_view key);
+};
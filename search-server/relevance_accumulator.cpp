@@ -0,0 +1,16 @@
+#include "relevance_accumulator.h"
+
+void RelevanceAccumulator::Resize(size_t ordinal_count) {
+    if (relevances_.size() < ordinal_count) {
+        relevances_.resize(ordinal_count, 0.0);
+        scored_.resize(ordinal_count, 0);
+    }
+}
+
+void RelevanceAccumulator::Reset() {
+    for (const int ordinal : touched_) {
+        relevances_[ordinal] = 0.0;
+        scored_[ordinal] = 0;
+    }
+    touched_.clear();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Накопитель релевантности документов, индексируемый порядковыми номерами документов.
+// Рассчитан на повторное использование между запросами: память не освобождается,
+// а при сбросе очищаются только затронутые запросом ячейки
+class RelevanceAccumulator {
+public:
+    // Увеличивает накопитель до ordinal_count ячеек
+    void Resize(size_t ordinal_count);
+
+    // Добавляет релевантность документу
+    void Add(int ordinal, double relevance) {
+        if (!scored_[ordinal]) {
+            scored_[ordinal] = 1;
+            touched_.push_back(ordinal);
+        }
+        relevances_[ordinal] += relevance;
+    }
+
+    // Вызывает callback(ordinal, relevance) для каждого найденного документа
+    template <typename Callback>
+    void ForEach(Callback callback) const {
+        for (const int ordinal : touched_) {
+            callback(ordinal, relevances_[ordinal]);
+        }
+    }
+
+    // Количество затронутых запросом документов
+    size_t GetTouchedCount() const {
+        return touched_.size();
+    }
+
+    // Очищает затронутые ячейки
+    void Reset();
+
+private:
+    std::vector<double> relevances_;
+    // Признак документа, уже добавленного в touched_
+    std::vector<uint8_t> scored_;
+    std::vector<int> touched_;
+};
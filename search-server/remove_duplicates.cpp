@@ -1,47 +1,212 @@
 #include "remove_duplicates.h"
 
-#include <iterator>
-#include <map>
-#include <set>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
-void RemoveDuplicates(SearchServer& search_server) {
-	if (search_server.GetDocumentCount() <= 1) {
-		return;
-	}
-	//Контейнеры для хранения слов документов
-	std::vector<std::string> current_cont, tmp_cont;
-	//Контейнер для хранения id дупликаторов
-	std::set<int> id_to_remove;
-	
-	for (auto it = search_server.begin(); it != search_server.end(); ++it) {
-		if (!search_server.GetWordFrequencies(*it).empty()) {
-			tmp_cont.clear();
-
-			//Заполняем временный вектор словами
-			for (const auto& [word, _] : search_server.GetWordFrequencies(*it)) {
-				tmp_cont.push_back(word);
-			}
+using namespace std::string_literals;
 
-			//Сравниваем временный вектор с другими документами
-			for (auto it_doc = std::next(it, 1); it_doc != search_server.end(); ++it_doc) {
-				current_cont.clear();
-				for (const auto& [word, _] : search_server.GetWordFrequencies(*it_doc)) {
-					current_cont.push_back(word);
-				}
-				//Запоминаем id документов-дупликаторов
-				if (current_cont == tmp_cont) {
-					id_to_remove.insert(*it_doc);
+namespace {
+
+using WordFreqs = WordFrequencies;
+
+// Перемешивание битов (финализатор splitmix64)
+uint64_t MixHash(uint64_t value) {
+	value ^= value >> 30;
+	value *= 0xBF58476D1CE4E5B9;
+	value ^= value >> 27;
+	value *= 0x94D049BB133111EB;
+	value ^= value >> 31;
+	return value;
+}
+
+// Подпись документа:
+// set_hash - хеш отсортированного множества слов, совпадает у точных дубликатов;
+// band_keys - хеши полос MinHash-подписи, вычисляются только при поиске почти-дубликатов
+struct DocumentSignature {
+	int id = 0;
+	WordFreqs words;
+	uint64_t set_hash = 0;
+	std::vector<uint64_t> band_keys;
+};
+
+void ComputeSignature(DocumentSignature& signature, const DuplicateSearchOptions& options,
+	size_t band_count) {
+	const size_t hash_count = band_count * options.rows_per_band;
+	std::vector<uint64_t> min_hashes(hash_count, std::numeric_limits<uint64_t>::max());
+
+	uint64_t set_hash = options.seed;
+	for (const auto [word, _] : signature.words) {
+		const uint64_t word_hash = std::hash<std::string_view>{}(word);
+		// Слова отсортированы, поэтому хеш не зависит от порядка слов в тексте
+		set_hash = MixHash(set_hash ^ word_hash);
+		for (size_t i = 0; i < hash_count; ++i) {
+			min_hashes[i] = std::min(min_hashes[i], MixHash(word_hash ^ (options.seed * (i + 1))));
+		}
+	}
+	signature.set_hash = set_hash;
+
+	signature.band_keys.resize(band_count);
+	for (size_t band = 0; band < band_count; ++band) {
+		uint64_t band_key = band;
+		for (size_t row = 0; row < options.rows_per_band; ++row) {
+			band_key = MixHash(band_key ^ min_hashes[band * options.rows_per_band + row]);
+		}
+		signature.band_keys[band] = band_key;
+	}
+}
+
+// Документы одного сервера: одинаковые слова имеют одинаковые номера в словаре
+bool HaveSameWords(const WordFreqs& lhs, const WordFreqs& rhs) {
+	if (lhs.size() != rhs.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < lhs.size(); ++i) {
+		if (lhs.GetTermId(i) != rhs.GetTermId(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Коэффициент Жаккара множеств слов: |A ∩ B| / |A ∪ B|
+double ComputeJaccardSimilarity(const WordFreqs& lhs, const WordFreqs& rhs) {
+	size_t common_count = 0;
+	size_t lhs_index = 0;
+	size_t rhs_index = 0;
+	while (lhs_index < lhs.size() && rhs_index < rhs.size()) {
+		if (lhs.GetTermId(lhs_index) == rhs.GetTermId(rhs_index)) {
+			++common_count;
+			++lhs_index;
+			++rhs_index;
+		}
+		else if (lhs.GetWord(lhs_index) < rhs.GetWord(rhs_index)) {
+			++lhs_index;
+		}
+		else {
+			++rhs_index;
+		}
+	}
+	return static_cast<double>(common_count) / (lhs.size() + rhs.size() - common_count);
+}
+
+// Политика выбирается по типу: параллельно считаются только сигнатуры документов,
+// группировка по подписям последовательная
+template <typename ExecutionPolicy>
+std::vector<int> FindDuplicatesImpl(ExecutionPolicy&&, const SearchServer& search_server,
+	const DuplicateSearchOptions& options) {
+	if (!(options.similarity_threshold > 0.0 && options.similarity_threshold <= 1.0)) {
+		throw std::invalid_argument("Similarity threshold must be in (0, 1]"s);
+	}
+	const bool find_similar = options.similarity_threshold < 1.0;
+	if (find_similar && (options.band_count == 0 || options.rows_per_band == 0)) {
+		throw std::invalid_argument("MinHash band count and rows per band must be positive"s);
+	}
+	const size_t band_count = find_similar ? options.band_count : 0;
+
+	std::vector<DocumentSignature> signatures;
+	signatures.reserve(search_server.GetDocumentCount());
+	for (const int document_id : search_server) {
+		WordFreqs words = search_server.GetWordFrequencies(document_id);
+		if (!words.empty()) {
+			signatures.push_back({ document_id, words, 0, {} });
+		}
+	}
+	// Параллельная версия считает сигнатуры в пуле потоков сервера
+	const auto compute_signature = [&signatures, &options, band_count](size_t i) {
+		ComputeSignature(signatures[i], options, band_count);
+	};
+	if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::parallel_policy>) {
+		search_server.GetThreadPool().ParallelFor(signatures.size(), compute_signature);
+	}
+	else {
+		for (size_t i = 0; i < signatures.size(); ++i) {
+			compute_signature(i);
+		}
+	}
+
+	// Точные дубликаты: документы группируются по хешу множества слов,
+	// при совпадении хеша множества сравниваются целиком
+	std::vector<int> duplicates;
+	std::vector<const DocumentSignature*> originals;
+	std::unordered_map<uint64_t, std::vector<const DocumentSignature*>> set_hash_to_originals;
+	set_hash_to_originals.reserve(signatures.size());
+	for (const DocumentSignature& signature : signatures) {
+		auto& same_hash = set_hash_to_originals[signature.set_hash];
+		const bool is_duplicate = std::any_of(same_hash.begin(), same_hash.end(),
+			[&signature](const DocumentSignature* original) {
+				return HaveSameWords(original->words, signature.words);
+			});
+		if (is_duplicate) {
+			duplicates.push_back(signature.id);
+		}
+		else {
+			same_hash.push_back(&signature);
+			originals.push_back(&signature);
+		}
+	}
+
+	if (find_similar) {
+		// Почти-дубликаты: кандидатами считаются более ранние оставленные документы
+		// хотя бы с одной совпавшей полосой подписи, сходство кандидата проверяется точно
+		std::vector<std::unordered_map<uint64_t, std::vector<const DocumentSignature*>>> band_buckets(band_count);
+		for (const DocumentSignature* signature : originals) {
+			bool is_duplicate = false;
+			for (size_t band = 0; band < band_count && !is_duplicate; ++band) {
+				const auto bucket = band_buckets[band].find(signature->band_keys[band]);
+				if (bucket == band_buckets[band].end()) {
+					continue;
 				}
+				is_duplicate = std::any_of(bucket->second.begin(), bucket->second.end(),
+					[&](const DocumentSignature* original) {
+						return ComputeJaccardSimilarity(original->words, signature->words)
+							>= options.similarity_threshold;
+					});
+			}
+			if (is_duplicate) {
+				duplicates.push_back(signature->id);
+				continue;
+			}
+			for (size_t band = 0; band < band_count; ++band) {
+				band_buckets[band][signature->band_keys[band]].push_back(signature);
 			}
 		}
 	}
-	//Удаляем документы-дупликаторы
-	for (const int id : id_to_remove) {
-		using namespace std::string_literals;
-		std::cout << "Found duplicate document id " << id << std::endl;
+
+	std::sort(duplicates.begin(), duplicates.end());
+	return duplicates;
+}
+
+} // namespace
+
+std::vector<int> FindDuplicates(const SearchServer& search_server, const DuplicateSearchOptions& options) {
+	return FindDuplicatesImpl(std::execution::seq, search_server, options);
+}
+
+std::vector<int> FindDuplicates(const std::execution::parallel_policy& policy,
+	const SearchServer& search_server, const DuplicateSearchOptions& options) {
+	return FindDuplicatesImpl(policy, search_server, options);
+}
+
+std::vector<int> RemoveDuplicates(SearchServer& search_server, const DuplicateSearchOptions& options) {
+	std::vector<int> duplicates = FindDuplicates(search_server, options);
+	for (const int id : duplicates) {
 		search_server.RemoveDocument(id);
 	}
-	id_to_remove.clear();
-}
\ No newline at end of file
+	return duplicates;
+}
+
+std::vector<int> RemoveDuplicates(const std::execution::parallel_policy& policy,
+	SearchServer& search_server, const DuplicateSearchOptions& options) {
+	std::vector<int> duplicates = FindDuplicates(policy, search_server, options);
+	for (const int id : duplicates) {
+		search_server.RemoveDocument(policy, id);
+	}
+	return duplicates;
+}
@@ -1,4 +1,38 @@
 #pragma once
 #include "search_server.h"
 
-void RemoveDuplicates(SearchServer& search_server);
\ No newline at end of file
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <vector>
+
+// Параметры поиска дубликатов.
+// similarity_threshold - минимальный коэффициент Жаккара множеств слов двух документов,
+// при котором более поздний документ считается дубликатом; 1.0 - только точные дубликаты.
+// Кандидаты в почти-дубликаты отбираются MinHash/LSH: подпись документа из
+// band_count * rows_per_band минимальных хешей делится на band_count полос, документы
+// с совпавшей полосой сравниваются точно. Порог отбора кандидатов примерно
+// (1 / band_count) ^ (1 / rows_per_band) и должен быть ниже similarity_threshold
+struct DuplicateSearchOptions {
+	double similarity_threshold = 1.0;
+	size_t band_count = 20;
+	size_t rows_per_band = 5;
+	uint64_t seed = 0x9E3779B97F4A7C15;
+};
+
+// Возвращает по возрастанию id документов, множество слов которых совпадает
+// (или сходно с порогом similarity_threshold) с множеством слов документа с меньшим id.
+// Документы без слов не считаются дубликатами
+std::vector<int> FindDuplicates(const SearchServer& search_server,
+	const DuplicateSearchOptions& options = {});
+
+// Параллельная версия: подписи документов вычисляются параллельно
+std::vector<int> FindDuplicates(const std::execution::parallel_policy& policy,
+	const SearchServer& search_server, const DuplicateSearchOptions& options = {});
+
+// Удаляет дубликаты из сервера и возвращает их id по возрастанию
+std::vector<int> RemoveDuplicates(SearchServer& search_server,
+	const DuplicateSearchOptions& options = {});
+
+std::vector<int> RemoveDuplicates(const std::execution::parallel_policy& policy,
+	SearchServer& search_server, const DuplicateSearchOptions& options = {});
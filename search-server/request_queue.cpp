@@ -7,10 +7,8 @@
     }
 
     std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-        return RequestQueue::AddFindRequest(
-            raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-                return document_status == status;
-            });
+        // Поиск по статусу может использовать кеш результатов сервера
+        return AddResult(raw_query, search_server_.FindTopDocuments(raw_query, status));
     }
 
     std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
@@ -26,3 +24,36 @@
         }
         return empty_request_count;
     }
+
+    std::vector<Document> RequestQueue::AddResult(const std::string& raw_query, std::vector<Document> documents) {
+        // увеличваем время за каждый запрос
+        ++step_time_;
+        // удаляем старые запросы
+        if (step_time_ > min_in_day_) {
+            if (requests_.front().count > 1) {
+                --requests_.front().count;
+            }
+            else {
+                requests_.pop_front();
+            }
+        }
+        // обработка пустого ответа на запрос
+        if (documents.empty()) {
+            if (requests_.empty() || requests_.back().query != empty_request_) {
+                requests_.push_back({ empty_request_, 1 });
+            }
+            else {
+                ++requests_.back().count;
+            }
+        }
+        // обработка непустого ответа на запрос
+        else {
+            if (requests_.empty() || requests_.back().query != raw_query) {
+                requests_.push_back({ raw_query, 1 });
+            }
+            else {
+                ++requests_.back().count;
+            }
+        }
+        return documents;
+    }
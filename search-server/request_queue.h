@@ -35,41 +35,13 @@ private:
     uint64_t step_time_ = 0;
     
     std::string empty_request_ = "empty request";
+
+    // Учитывает результаты поиска запроса в статистике и возвращает их
+    std::vector<Document> AddResult(const std::string& raw_query, std::vector<Document> documents);
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate)
 {
-    // увеличваем время за каждый запрос
-    ++step_time_;
-    // удаляем старые запросы
-    if (step_time_ > min_in_day_) {
-        if (requests_.front().count > 1) {
-            --requests_.front().count;
-        }
-        else {
-            requests_.pop_front();
-        }
-    }
-    // результаты поиска запроса
-    auto documents = search_server_.FindTopDocuments(raw_query, document_predicate);
-    // обработка пустого ответа на запрос
-    if (documents.empty()) {
-        if (requests_.empty() || requests_.back().query != empty_request_) {
-            requests_.push_back({ empty_request_, 1 });
-        }
-        else {
-            ++requests_.back().count;
-        }
-    }
-    // обработка непустого ответа на запрос
-    else {
-        if (requests_.empty() || requests_.back().query != raw_query) {
-            requests_.push_back({ raw_query, 1 });
-        }
-        else {
-            ++requests_.back().count;
-        }
-    }
-    return documents;
+    return AddResult(raw_query, search_server_.FindTopDocuments(raw_query, document_predicate));
 }
\ No newline at end of file
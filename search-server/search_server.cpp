@@ -1,7 +1,11 @@
 #include <algorithm>
-#include <deque>
+#include <atomic>
+#include <cmath>
+#include <exception>
 #include <execution>
 #include <numeric>
+#include <set>
+#include <thread>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -23,57 +27,225 @@ SearchServer::SearchServer(std::string_view stop_words_text)
 void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
     const std::vector<int>& ratings) {
 
-    if (document_id < 0) {
-        throw std::invalid_argument("Invalid document_id"s);
+    CheckNewDocumentId(document_id);
+
+    // Текст документа не сохраняется: индекс хранит собственные копии слов.
+    // Буферы слов переиспользуются между вызовами
+    thread_local std::vector<std::string_view> words;
+    thread_local WordFreqs word_freqs;
+    {
+        SearchStageTimer timer(SearchStage::TOKENIZE);
+        text_analyzer_.ComputeWordFreqs(document, words, word_freqs);
     }
-    if (documents_.count(document_id) > 0) {
-        throw std::invalid_argument("Invalid document_id. ID already exists"s);
+
+    // Документу выдается следующий порядковый номер, поэтому он
+    // дописывается в конец списков документов своих слов
+    const int ordinal = static_cast<int>(ordinal_to_document_id_.size());
+    ordinal_to_document_id_.push_back(document_id);
+    word_to_document_freqs_.SetDocumentWordCount(ordinal, words.size());
+    // Слова документа идут по алфавиту, как и в прямом индексе
+    document_to_word_freqs_.AllocateDocument(ordinal, word_freqs.size());
+    for (size_t i = 0; i < word_freqs.size(); ++i) {
+        const auto [word, term_freq] = word_freqs[i];
+        const std::string_view stored_word = word_to_document_freqs_.Add(word, ordinal, term_freq);
+        document_to_word_freqs_.SetWord(ordinal, i, word_to_document_freqs_.FindTermId(stored_word), term_freq);
+    }
+    documents_.emplace(document_id, DocumentData{ ordinal });
+    document_columns_.Resize(ordinal_to_document_id_.size());
+    document_columns_.Add(ordinal, status, ComputeAverageRating(ratings));
+    log_document_count_ = std::log(GetDocumentCount());
+    document_ids_.emplace(document_id);
+    ++index_generation_;
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::AddDocumentsImpl(ExecutionPolicy&& policy, const std::vector<NewDocument>& documents) {
+    // Проверяем id до изменения сервера, включая повторы внутри пакета
+    std::set<int> new_ids;
+    for (const NewDocument& document : documents) {
+        CheckNewDocumentId(document.id);
+        if (!new_ids.insert(document.id).second) {
+            throw std::invalid_argument("Invalid document_id. ID already exists"s);
+        }
     }
-    storage_.emplace_back(document);
 
-    auto words = SplitIntoWordsNoStop(storage_.back());
+    const int first_ordinal = static_cast<int>(ordinal_to_document_id_.size());
+
+    // Каждая часть пакета - непрерывный диапазон документов со своим частичным индексом.
+    // Первое исключение из частей передается после их завершения
+    const size_t part_count = std::max<size_t>(1, std::min(documents.size(), thread_pool_->GetThreadCount()));
+    const size_t part_size = (documents.size() + part_count - 1) / part_count;
+    std::vector<StringHashMap<PostingList>> part_indexes(part_count);
+    std::vector<WordFreqs> document_word_freqs(documents.size());
+    std::vector<size_t> document_word_counts(documents.size());
+
+    ForEachIndex(policy, part_count,
+        [&](size_t part) {
+            std::vector<std::string_view> words;
+            auto& part_index = part_indexes[part];
+            const size_t part_end = std::min(documents.size(), (part + 1) * part_size);
+            for (size_t i = part * part_size; i < part_end; ++i) {
+                {
+                    SearchStageTimer timer(SearchStage::TOKENIZE);
+                    text_analyzer_.ComputeWordFreqs(documents[i].text, words, document_word_freqs[i]);
+                }
+                document_word_counts[i] = words.size();
+                const int ordinal = first_ordinal + static_cast<int>(i);
+                for (const auto& [word, term_freq] : document_word_freqs[i]) {
+                    auto* entry = part_index.FindEntry(word);
+                    if (entry == nullptr) {
+                        entry = &part_index.Insert(word, PostingList{});
+                    }
+                    entry->value.ordinals.push_back(ordinal);
+                    entry->value.term_freqs.push_back(term_freq);
+                }
+            }
+        });
 
-    const double inv_word_count = 1.0 / words.size();
-    for (std::string_view word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        document_to_word_freqs_[document_id][word] += inv_word_count;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        word_to_document_freqs_.SetDocumentWordCount(first_ordinal + static_cast<int>(i), document_word_counts[i]);
+    }
+
+    // Части следуют по возрастанию номеров, поэтому списки документов дописываются в конец
+    for (const auto& part_index : part_indexes) {
+        for (const auto& [word, postings] : part_index) {
+            word_to_document_freqs_.Append(word, postings);
+        }
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
-    document_ids_.emplace(document_id);
 
+    // Прямой индекс хранит номера слов словаря. Участки документов выделяются
+    // последовательно, а заполняются параллельно
+    for (size_t i = 0; i < documents.size(); ++i) {
+        document_to_word_freqs_.AllocateDocument(first_ordinal + static_cast<int>(i), document_word_freqs[i].size());
+    }
+    ForEachIndex(policy, documents.size(),
+        [&](size_t i) {
+            const int ordinal = first_ordinal + static_cast<int>(i);
+            for (size_t j = 0; j < document_word_freqs[i].size(); ++j) {
+                const auto [word, term_freq] = document_word_freqs[i][j];
+                document_to_word_freqs_.SetWord(ordinal, j, word_to_document_freqs_.FindTermId(word), term_freq);
+            }
+        });
+
+    document_columns_.Resize(first_ordinal + documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const NewDocument& document = documents[i];
+        const int ordinal = first_ordinal + static_cast<int>(i);
+        ordinal_to_document_id_.push_back(document.id);
+        documents_.emplace(document.id, DocumentData{ ordinal });
+        document_columns_.Add(ordinal, document.status, ComputeAverageRating(document.ratings));
+        document_ids_.emplace(document.id);
+    }
+    log_document_count_ = std::log(GetDocumentCount());
+    ++index_generation_;
+}
+
+void SearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    AddDocumentsImpl(std::execution::seq, documents);
+}
+
+void SearchServer::AddDocuments(const std::execution::sequenced_policy& policy, const std::vector<NewDocument>& documents) {
+    AddDocumentsImpl(policy, documents);
+}
 
+void SearchServer::AddDocuments(const std::execution::parallel_policy& policy, const std::vector<NewDocument>& documents) {
+    AddDocumentsImpl(policy, documents);
 }
 
 void SearchServer::PrintDocument(int document_id) {
-    if (document_to_word_freqs_.count(document_id)) {
-        std::cout << "Size: "s << document_to_word_freqs_[document_id].size() << std::endl;
+    if (documents_.count(document_id)) {
+        const WordFrequencies word_freqs = GetWordFrequencies(document_id);
+        std::cout << "Size: "s << word_freqs.size() << std::endl;
         std::cout << "Words: "s;
-        for (auto [word, _] : document_to_word_freqs_[document_id]) {
+        for (auto [word, _] : word_freqs) {
             std::cout << word << ' ';
         }std::cout << std::endl;
     }
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(
-        raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    size_t top_count) const {
+    // Статус проверяется по битовому массиву документов статуса
+    const DocumentBitmap& status_documents = document_columns_.GetStatusDocuments(status);
+    const auto document_filter = [&status_documents](int ordinal) {
+        return status_documents.Test(ordinal);
+    };
+    Query& query = TextAnalyzer::GetThreadQuery();
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        text_analyzer_.ParseQuery(raw_query, query);
+    }
+    if (!result_cache_.IsEnabled()) {
+        return FindTopDocumentsForQuery(query, document_filter, top_count);
+    }
+
+    thread_local std::string key;
+    MakeResultCacheKey(query, status, top_count, key);
+    std::vector<Document> documents;
+    if (result_cache_.Find(key, index_generation_, documents)) {
+        SearchStats::Add(SearchCounter::CACHE_HITS);
+    }
+    else {
+        SearchStats::Add(SearchCounter::CACHE_MISSES);
+        documents = FindTopDocumentsForQuery(query, document_filter, top_count);
+        result_cache_.Insert(key, index_generation_, documents);
+    }
+    return documents;
 }
 
 // Последовательная явная версия поиска документов
-std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy& policy,
-    std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(raw_query, status);
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy&,
+    std::string_view raw_query, DocumentStatus status, size_t top_count) const {
+    return FindTopDocuments(raw_query, status, top_count);
 }
 
 // Параллельная версия поиска документов
 std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy& policy,
-    std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy,
-        raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
+    std::string_view raw_query, DocumentStatus status, size_t top_count) const {
+    Query query;
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        query = text_analyzer_.ParseQuery(raw_query);
+    }
+    const DocumentBitmap& status_documents = document_columns_.GetStatusDocuments(status);
+    return FindTopDocumentsForQuery(policy, query, [&status_documents](int ordinal) {
+        return status_documents.Test(ordinal);
+    }, top_count);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    int min_rating, int max_rating, size_t top_count) const {
+    Query& query = TextAnalyzer::GetThreadQuery();
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        text_analyzer_.ParseQuery(raw_query, query);
+    }
+    DocumentBitmap documents;
+    document_columns_.FindByRating(status, min_rating, max_rating, documents);
+    return FindTopDocumentsForQuery(query, [&documents](int ordinal) {
+        return documents.Test(ordinal);
+    }, top_count);
+}
+
+// Последовательная явная версия поиска по статусу и диапазону рейтинга
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy&,
+    std::string_view raw_query, DocumentStatus status, int min_rating, int max_rating, size_t top_count) const {
+    return FindTopDocuments(raw_query, status, min_rating, max_rating, top_count);
+}
+
+// Битовый массив документов строится до запуска задач и только читается ими
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy& policy,
+    std::string_view raw_query, DocumentStatus status, int min_rating, int max_rating, size_t top_count) const {
+    Query query;
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        query = text_analyzer_.ParseQuery(raw_query);
+    }
+    DocumentBitmap documents;
+    document_columns_.FindByRating(status, min_rating, max_rating, documents);
+    return FindTopDocumentsForQuery(policy, query, [&documents](int ordinal) {
+        return documents.Test(ordinal);
+    }, top_count);
 }
 
 // Возвращает количество документов
@@ -90,77 +262,131 @@ std::set<int>::const_iterator SearchServer::end() const {
 }
 
 //Метод получения частот слов по id документа
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-
-    if (document_ids_.count(document_id) != 0) {
-        return document_to_word_freqs_.at(document_id);
+WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    const auto it = documents_.find(document_id);
+    if (it != documents_.end()) {
+        return WordFrequencies(word_to_document_freqs_, document_to_word_freqs_, it->second.ordinal);
     }
     // Возвращает пустой список, если не нашелся документ
-    static std::map<std::string_view, double> word_frequencies;
-    return word_frequencies;
+    return WordFrequencies();
 }
 
 //Метод удаления документов из поискового сервера
 void SearchServer::RemoveDocument(int document_id) {
-    if (document_to_word_freqs_.count(document_id) == 0) {
+    if (documents_.count(document_id) == 0) {
         throw std::invalid_argument("Invalid ID. ID is doesn't exist"s);
     }
 
-    // Удаляем документы из списка документов и частот для каждого слово
-    // Определяем все слова, имеющиеся в документе
-    for (const auto& [word, _] : document_to_word_freqs_[document_id]) {
+    const int ordinal = documents_.at(document_id).ordinal;
 
-        // Удаляем документы из списка документов и частот для каждого слова
-        word_to_document_freqs_[word].erase(document_id);
+    // Удаляем документы из списка документов и частот для каждого слово
+    // Слова документа берутся из его участка прямого индекса
+    const size_t begin = document_to_word_freqs_.GetDocumentBegin(ordinal);
+    const size_t end = begin + document_to_word_freqs_.GetDocumentWordCount(ordinal);
+    for (size_t position = begin; position < end; ++position) {
+        const uint32_t term_id = document_to_word_freqs_.GetTermId(position);
+        word_to_document_freqs_.Remove(term_id, ordinal);
+        word_to_document_freqs_.EraseIfEmpty(term_id);
     }
     // Удаляем документ из списка документов
     documents_.erase(document_id);
+    log_document_count_ = std::log(GetDocumentCount());
+    ordinal_to_document_id_[ordinal] = -1;
+    document_columns_.Remove(ordinal);
 
     // Удаляем документ из списка слов и частот для всех документов
-    document_to_word_freqs_.erase(document_id);
+    document_to_word_freqs_.RemoveDocument(ordinal);
 
     // Удаляем id документа из списка id документов
     document_ids_.erase(document_id);
+    ++index_generation_;
 
+    CompactIfNeeded();
 }
 
-void SearchServer::RemoveDocument(const std::execution::sequenced_policy& policy, int document_id) {
+// Последовательная явная версия удаления документа
+void SearchServer::RemoveDocument(const std::execution::sequenced_policy&, int document_id) {
     SearchServer::RemoveDocument(document_id);
 }
 
 // Параллельный метод удаления документов из поискового сервера
 void SearchServer::RemoveDocument(const std::execution::parallel_policy& policy, int document_id) {
-    if (document_to_word_freqs_.count(document_id) == 0) {
+    if (documents_.count(document_id) == 0) {
         throw std::invalid_argument("Invalid ID. ID is doesn't exist"s);
     }
-    const auto& curr_map = document_to_word_freqs_[document_id];
-    std::vector<std::string_view> words_to_remove_ptr(curr_map.size());
+    const int ordinal = documents_.at(document_id).ordinal;
 
-    // Определяем список указателей на слова, которые содержатся в 
-    // документе с document_id 
-    std::transform(policy,
-        curr_map.begin(),
-        curr_map.end(),
-        words_to_remove_ptr.begin(),
-        [](auto& word_freq) { return word_freq.first; }
-    );
+    // Номера слов документа берутся из его участка прямого индекса
+    const size_t begin = document_to_word_freqs_.GetDocumentBegin(ordinal);
+    const size_t word_count = document_to_word_freqs_.GetDocumentWordCount(ordinal);
 
     // Удаляем документ из списка документов для каждого слова
-    std::for_each(policy,
-        words_to_remove_ptr.cbegin(), words_to_remove_ptr.cend(),
-        [this, document_id](std::string_view word_ptr) {
-            word_to_document_freqs_[word_ptr].erase(document_id);
+    ForEachIndex(policy, word_count,
+        [this, ordinal, begin](size_t i) {
+            word_to_document_freqs_.Remove(document_to_word_freqs_.GetTermId(begin + i), ordinal);
         }
     );
+    // Удаление слов изменяет словарь, поэтому выполняется последовательно
+    for (size_t position = begin; position < begin + word_count; ++position) {
+        word_to_document_freqs_.EraseIfEmpty(document_to_word_freqs_.GetTermId(position));
+    }
 
     //Удаляем документ из списка документов
     documents_.erase(document_id);
+    log_document_count_ = std::log(GetDocumentCount());
+    ordinal_to_document_id_[ordinal] = -1;
+    document_columns_.Remove(ordinal);
 
     // Удаляем документ из списка слов и частот для всех документов
-    document_to_word_freqs_.erase(document_id);
+    document_to_word_freqs_.RemoveDocument(ordinal);
 
     // Удаляем id документа из списка id документов
     document_ids_.erase(document_id);
+    ++index_generation_;
+
+    CompactIfNeeded();
+}
+
+void SearchServer::Compact() {
+    // Переносим слова в новую арену. Прямой индекс хранит номера слов,
+    // которые при переносе не меняются
+    word_to_document_freqs_.Compact();
+
+    // Перенумеровываем документы без пропусков на месте удаленных
+    std::vector<int> new_ordinals(ordinal_to_document_id_.size(), -1);
+    std::vector<int> ordinal_to_document_id;
+    ordinal_to_document_id.reserve(documents_.size());
+    for (size_t ordinal = 0; ordinal < ordinal_to_document_id_.size(); ++ordinal) {
+        const int document_id = ordinal_to_document_id_[ordinal];
+        if (document_id != -1) {
+            new_ordinals[ordinal] = static_cast<int>(ordinal_to_document_id.size());
+            documents_.at(document_id).ordinal = new_ordinals[ordinal];
+            ordinal_to_document_id.push_back(document_id);
+        }
+    }
+    word_to_document_freqs_.RemapOrdinals(new_ordinals);
+    document_to_word_freqs_.RemapOrdinals(new_ordinals, ordinal_to_document_id.size());
+    document_columns_.RemapOrdinals(new_ordinals, ordinal_to_document_id.size());
+    ordinal_to_document_id_ = std::move(ordinal_to_document_id);
+}
+
+SearchServer::StorageStats SearchServer::GetStorageStats() const {
+    const ArenaStats arena_stats = word_to_document_freqs_.GetArenaStats();
+    const size_t removed_count = ordinal_to_document_id_.size() - documents_.size();
+    return {
+        arena_stats.live_bytes + documents_.size() * sizeof(int) + document_to_word_freqs_.GetLiveBytes(),
+        arena_stats.dead_bytes + removed_count * sizeof(int) + document_to_word_freqs_.GetDeadBytes(),
+        arena_stats.live_bytes,
+        arena_stats.dead_bytes,
+        removed_count,
+    };
+}
+
+void SearchServer::CompactIfNeeded() {
+    const StorageStats stats = GetStorageStats();
+    if (stats.dead_bytes >= COMPACTION_MIN_DEAD_BYTES && stats.dead_bytes > stats.live_bytes) {
+        Compact();
+    }
 }
 
 // Последовательная версия поиска совпадающих слов документа
@@ -171,9 +397,13 @@ SearchServer::MyTuple SearchServer::MatchDocument(std::string_view raw_query,
         throw std::out_of_range("Invalid document id. Document id is doesn't exist"s);
     }
     // Если неверный запрос, то выбросится исключение std::invalid_argument
-    const auto& query = ParseQuery(raw_query, true);
+    Query& query = TextAnalyzer::GetThreadQuery();
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        text_analyzer_.ParseQuery(raw_query, query, true);
+    }
 
-    const auto& curr_map = document_to_word_freqs_.at(document_id);
+    const WordFrequencies curr_map = GetWordFrequencies(document_id);
 
     std::vector<std::string_view> matched_words;
     matched_words.reserve(query.plus_words.size());
@@ -182,7 +412,7 @@ SearchServer::MyTuple SearchServer::MatchDocument(std::string_view raw_query,
     for (std::string_view word : query.minus_words) {
         if (curr_map.count(word) != 0) {
             matched_words.clear();
-            return { matched_words, documents_.at(document_id).status };
+            return { matched_words, document_columns_.GetStatus(documents_.at(document_id).ordinal) };
         }
     }
 
@@ -193,10 +423,11 @@ SearchServer::MyTuple SearchServer::MatchDocument(std::string_view raw_query,
         }
     }
 
-    return { matched_words, documents_.at(document_id).status };
+    return { matched_words, document_columns_.GetStatus(documents_.at(document_id).ordinal) };
 }
 
-SearchServer::MyTuple SearchServer::MatchDocument(const std::execution::sequenced_policy& policy, std::string_view raw_query, int document_id) const {
+// Последовательная явная версия поиска совпадающих слов документа
+SearchServer::MyTuple SearchServer::MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const {
     return MatchDocument(raw_query, document_id);
 }
 
@@ -204,69 +435,161 @@ SearchServer::MyTuple SearchServer::MatchDocument(const std::execution::sequence
 SearchServer::MyTuple SearchServer::MatchDocument(const std::execution::parallel_policy& policy, std::string_view raw_query, int document_id) const {
 
     // Если несуществующий document_id, выбрасывается исключение std::out_of_range
-    if (document_to_word_freqs_.count(document_id) == 0) {
+    if (documents_.count(document_id) == 0) {
         throw std::out_of_range("Invalid document id. Document id is doesn't exist"s);
     }
     // Если неверный запрос, то выбросится исключение std::invalid_argument
-    const auto& query = ParseQuery(raw_query, false);
+    Query query;
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        query = text_analyzer_.ParseQuery(raw_query, false);
+    }
 
-    const auto& curr_map = document_to_word_freqs_.at(document_id);
+    const WordFrequencies curr_map = GetWordFrequencies(document_id);
 
     // Проверяем документ на наличеие минус-слов
-    if (std::any_of(policy,
-        query.minus_words.begin(), query.minus_words.end(),
-        [&curr_map](std::string_view word_ref) {
-            return  (curr_map.count(word_ref) != 0); })) {
-
+    std::atomic<bool> has_minus_word = false;
+    ForEachIndex(policy, query.minus_words.size(),
+        [&](size_t i) {
+            if (curr_map.count(query.minus_words[i]) != 0) {
+                has_minus_word.store(true, std::memory_order_relaxed);
+            }
+        });
+    if (has_minus_word) {
         // Возвращаем пустой вектор слов при наличии минус-слова
         std::vector<std::string_view> matched_words;
-        return { matched_words, documents_.at(document_id).status };
+        return { matched_words, document_columns_.GetStatus(documents_.at(document_id).ordinal) };
     }
 
+    // Отмечаем плюс-слова, что имеются в документе
+    std::vector<char> is_matched(query.plus_words.size());
+    ForEachIndex(policy, query.plus_words.size(),
+        [&](size_t i) {
+            is_matched[i] = curr_map.count(query.plus_words[i]) != 0;
+        });
+
     std::vector<std::string_view> matched_words;
     matched_words.reserve(query.plus_words.size());
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        if (is_matched[i]) {
+            matched_words.push_back(query.plus_words[i]);
+        }
+    }
 
-    // Добавляем в результат только те плюс-слова, что имеются в документе
-    auto end = std::copy_if(policy,
-        query.plus_words.begin(), query.plus_words.end(),
-        matched_words.begin(),
-        [&curr_map](std::string_view word_ref) {
-
-            return (curr_map.count(word_ref) != 0);
-        });
-
-    // Удаляем лишние элементы
-    matched_words.erase(end, matched_words.end());
     // Сортируем и удаляем дубликаты
     std::sort(matched_words.begin(), matched_words.end());
-    end = std::unique(matched_words.begin(), end);
+    auto end = std::unique(matched_words.begin(), matched_words.end());
     matched_words.erase(end, matched_words.end());
 
-    return { matched_words, documents_.at(document_id).status };
+    return { matched_words, document_columns_.GetStatus(documents_.at(document_id).ordinal) };
 }
 
-bool SearchServer::IsStopWord(std::string_view word) const {
-    return stop_words_.count(word) > 0;
+namespace {
+
+// Во сколько раз частот слов документа должно быть больше, чем слов запроса,
+// чтобы слова запроса искались в частотах по одному, а не слиянием списков
+const size_t MATCH_PROBE_MIN_RATIO = 8;
+
+// Вызывает func(word) для слов отсортированного списка words, которые есть
+// в частотах слов документа, пока func возвращает true
+template <typename Func>
+void ForEachCommonWord(const std::vector<std::string_view>& words, const WordFrequencies& word_freqs, Func func) {
+    if (words.size() * MATCH_PROBE_MIN_RATIO < word_freqs.size()) {
+        for (std::string_view word : words) {
+            if (word_freqs.count(word) != 0 && !func(word)) {
+                return;
+            }
+        }
+        return;
+    }
+    size_t position = 0;
+    for (std::string_view word : words) {
+        while (position < word_freqs.size() && word_freqs.GetWord(position) < word) {
+            ++position;
+        }
+        if (position == word_freqs.size()) {
+            return;
+        }
+        if (word_freqs.GetWord(position) == word && !func(word)) {
+            return;
+        }
+    }
 }
 
-bool SearchServer::IsValidWord(std::string_view word) {
-    // A valid word must not contain special characters
-    return std::none_of(word.begin(), word.end(), [](char c) {
-        return c >= '\0' && c < ' ';
+} // namespace
+
+template <typename ExecutionPolicy>
+void SearchServer::MatchDocumentsImpl(ExecutionPolicy&& policy, const Query& query,
+    const std::vector<int>& document_ids, DocumentMatches& matches) const {
+    // Проверяем все id до проверки документов, заодно записываем статусы
+    matches.Reset(document_ids.size(), query.plus_words.size());
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        const auto it = documents_.find(document_ids[i]);
+        if (it == documents_.end()) {
+            throw std::out_of_range("Invalid document id. Document id is doesn't exist"s);
+        }
+        matches.ordinals_[i] = it->second.ordinal;
+        matches.statuses_[i] = document_columns_.GetStatus(it->second.ordinal);
+    }
+
+    // Плюс- и минус-слова отсортированы и без повторов, поэтому
+    // сравниваются со словами документа в прямом индексе слиянием
+    ForEachIndex(policy, document_ids.size(),
+        [&](size_t i) {
+            const WordFrequencies word_freqs(word_to_document_freqs_, document_to_word_freqs_, matches.ordinals_[i]);
+
+            bool has_minus_word = false;
+            ForEachCommonWord(query.minus_words, word_freqs, [&has_minus_word](std::string_view) {
+                has_minus_word = true;
+                return false;
+            });
+            if (has_minus_word) {
+                return;
+            }
+            std::string_view* matched_words = matches.words_.data() + i * matches.word_capacity_;
+            size_t& matched_count = matches.word_counts_[i];
+            ForEachCommonWord(query.plus_words, word_freqs, [&](std::string_view word) {
+                matched_words[matched_count++] = word;
+                return true;
+            });
         });
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string& text) const {
-    std::vector<std::string_view> words;
-    for (std::string_view word : SplitIntoWordsView(text)) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("Word ["s + std::string{word} + "] is invalid"s);
-        }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
-        }
+void SearchServer::MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids,
+    DocumentMatches& matches) const {
+    Query& query = TextAnalyzer::GetThreadQuery();
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        text_analyzer_.ParseQuery(raw_query, query);
+    }
+    MatchDocumentsImpl(std::execution::seq, query, document_ids, matches);
+}
+
+// Последовательная явная версия пакетной проверки документов
+void SearchServer::MatchDocuments(const std::execution::sequenced_policy&, std::string_view raw_query,
+    const std::vector<int>& document_ids, DocumentMatches& matches) const {
+    MatchDocuments(raw_query, document_ids, matches);
+}
+
+void SearchServer::MatchDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query,
+    const std::vector<int>& document_ids, DocumentMatches& matches) const {
+    // Запрос не берется из потока: поток может выполнять задачи других запросов,
+    // пока ждет завершения своих
+    Query query;
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        text_analyzer_.ParseQuery(raw_query, query);
+    }
+    MatchDocumentsImpl(policy, query, document_ids, matches);
+}
+
+void SearchServer::CheckNewDocumentId(int document_id) const {
+    if (document_id < 0) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+    if (documents_.count(document_id) > 0) {
+        throw std::invalid_argument("Invalid document_id. ID already exists"s);
     }
-    return words;
 }
 
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
@@ -278,59 +601,93 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
-    if (text.empty()) {
-        throw std::invalid_argument("Query word is empty"s);
-    }
-    std::string_view word = text;
-    bool is_minus = false;
-    if (word[0] == '-') {
-        is_minus = true;
-        word = word.substr(1);
-    }
-    // Не обрабатываем пустые слова, а также слова, состоящие из двойного минуса или
-    // имеющие спецсимволы
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-        throw std::invalid_argument("Query word ["s + std::string{text} + "] is invalid"s);
-    }
-    return { word, is_minus, IsStopWord(word) };
+double SearchServer::ComputeWordInverseDocumentFreq(const PostingList& postings) const {
+    return log_document_count_ - postings.log_document_freq;
 }
 
-// Разбивает запрос на плюс- и минус-слова
-// bool remove_duplicates используется для однопоточной версии
-SearchServer::Query SearchServer::ParseQuery(std::string_view text, const bool remove_duplicates) const {
-    SearchServer::Query result;
-    auto words = SplitIntoWordsView(text);
+RelevanceAccumulator& SearchServer::GetThreadAccumulator() {
+    thread_local RelevanceAccumulator accumulator;
+    return accumulator;
+}
 
+ConcurrentPool<RelevanceAccumulator>& SearchServer::GetAccumulatorPool() {
+    static ConcurrentPool<RelevanceAccumulator> pool;
+    return pool;
+}
 
-    for (std::string_view word : words) {
-        // Если слово некорректное, то будет выброшено исключение
-        auto query_word = ParseQueryWord(word);
+bool SearchServer::UseDocumentRanges(const Query& query) const {
+    return parallel_accumulation_ == ParallelAccumulation::DOCUMENT_RANGES
+        && query.plus_words.size() <= MAX_DOCUMENT_RANGE_QUERY_WORDS
+        && thread_pool_->GetThreadCount() > 1
+        && ordinal_to_document_id_.size() >= 2 * static_cast<size_t>(MIN_DOCUMENT_RANGE_SIZE);
+}
 
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.push_back(query_word.data);
-            }
-            else {
-                result.plus_words.push_back(query_word.data);
-            }
-        }
-    }
+void SearchServer::SetParallelAccumulation(ParallelAccumulation accumulation) {
+    parallel_accumulation_ = accumulation;
+}
 
-    // Сортируем и удаляем дубликаты слов
-    if (remove_duplicates) {
-        std::sort(result.minus_words.begin(), result.minus_words.end());
-        std::sort(result.plus_words.begin(), result.plus_words.end());
-        result.minus_words.erase(std::unique(result.minus_words.begin(), result.minus_words.end()), result.minus_words.end());
-        result.plus_words.erase(std::unique(result.plus_words.begin(), result.plus_words.end()), result.plus_words.end());
-    }
+ParallelAccumulation SearchServer::GetParallelAccumulation() const {
+    return parallel_accumulation_;
+}
 
-    return result;
+void SearchServer::SetPostingsFormat(PostingsFormat format) {
+    word_to_document_freqs_.SetPostingsFormat(format);
 }
 
-// Existence required
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
-    return log(SearchServer::GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+PostingsFormat SearchServer::GetPostingsFormat() const {
+    return word_to_document_freqs_.GetPostingsFormat();
+}
+
+void SearchServer::SetQueryEvaluation(QueryEvaluation evaluation) {
+    query_evaluation_ = evaluation;
+}
+
+QueryEvaluation SearchServer::GetQueryEvaluation() const {
+    return query_evaluation_;
+}
+
+void SearchServer::SetResultCacheCapacity(size_t capacity) {
+    result_cache_.SetCapacity(capacity);
+}
+
+QueryResultCache::Stats SearchServer::GetResultCacheStats() const {
+    return result_cache_.GetStats();
+}
+
+MinusWordFilter SearchServer::MakeMinusWordFilter(const Query& query) const {
+    SearchStageTimer timer(SearchStage::MINUS_FILTER);
+    return MinusWordFilter(word_to_document_freqs_, query.minus_words);
+}
+
+SearchStatsSnapshot SearchServer::GetStatsSnapshot() {
+    return SearchStats::GetSnapshot();
+}
+
+void SearchServer::ResetStats() {
+    SearchStats::Reset();
+}
+
+void SearchServer::SetThreadPool(std::shared_ptr<ThreadPool> thread_pool) {
+    thread_pool_ = std::move(thread_pool);
+}
+
+ThreadPool& SearchServer::GetThreadPool() const {
+    return *thread_pool_;
+}
+
+void SearchServer::MakeResultCacheKey(const Query& query, DocumentStatus status, size_t top_count, std::string& key) {
+    // Слова не содержат пробелов, минус-слова отмечены минусом
+    key = std::to_string(static_cast<int>(status));
+    key += ' ';
+    key += std::to_string(top_count);
+    for (std::string_view word : query.plus_words) {
+        key += ' ';
+        key += word;
+    }
+    for (std::string_view word : query.minus_words) {
+        key += " -"sv;
+        key += word;
+    }
 }
 
 void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status,
@@ -1,24 +1,94 @@
 #pragma once
 #include "document.h"
 #include "string_processing.h"
+#include "text_analyzer.h"
 #include "read_input_functions.h"
 #include "concurrent_map.h"
+#include "document_columns.h"
+#include "document_matches.h"
+#include "forward_index.h"
+#include "inverted_index.h"
+#include "minus_word_filter.h"
+#include "posting_cursor.h"
+#include "query_result_cache.h"
+#include "search_stats.h"
+#include "string_hash_map.h"
+#include "term_arena.h"
+#include "thread_pool.h"
+#include "relevance_accumulator.h"
+#include "top_documents.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
-#include <deque>
 #include <execution>
 #include <set>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
+#include <limits>
 #include <map>
+#include <numeric>
+#include <optional>
 #include <utility>
 #include <stdexcept>
 
 
+// Количество документов в выдаче по умолчанию
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
+// Минимальный объем мертвых байт, при котором выполняется автоматическое уплотнение
+const size_t COMPACTION_MIN_DEAD_BYTES = 64 * 1024;
+
+// Документ для пакетного добавления в поисковый сервер
+struct NewDocument {
+    int id;
+    std::string_view text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+// Количество корзин ConcurrentMap при параллельном накоплении релевантности
+const size_t CONCURRENT_MAP_BUCKET_COUNT = 128;
+
+// Способ накопления релевантности в параллельном поиске:
+// CONCURRENT_MAP - задачи делят слова запроса и пишут в общий словарь с блокировкой
+// корзины на каждое вхождение слова;
+// PARTIAL_TABLES - задачи делят слова запроса, каждая накапливает релевантность
+// в собственном плотном массиве без блокировок, массивы объединяются после завершения задач;
+// DOCUMENT_RANGES - задачи делят диапазон номеров документов и отбирают лучшие документы
+// своего диапазона алгоритмом MaxScore, порог выдачи общий для всех задач.
+// Запрос из одного слова с длинным списком документов тоже выполняется всеми потоками.
+// Длинные запросы и индексы меньше двух диапазонов DOCUMENT_RANGES ищет как PARTIAL_TABLES:
+// на них MaxScore медленнее полного перебора. По умолчанию PARTIAL_TABLES
+enum class ParallelAccumulation {
+    CONCURRENT_MAP,
+    PARTIAL_TABLES,
+    DOCUMENT_RANGES,
+};
+
+// Минимальное количество номеров документов в диапазоне задачи DOCUMENT_RANGES
+const int MIN_DOCUMENT_RANGE_SIZE = 512;
+
+// Наибольшее количество плюс-слов запроса, который DOCUMENT_RANGES ищет по диапазонам
+const size_t MAX_DOCUMENT_RANGE_QUERY_WORDS = 8;
+
+// Способ отбора лучших документов в последовательном поиске:
+// EXHAUSTIVE - релевантность считается для всех документов со словами запроса;
+// MAX_SCORE - документы перебираются по возрастанию номеров, а слова с малой верхней
+// границей вклада проверяются только у документов, которые еще могут попасть в выдачу.
+// Выдача обоих способов совпадает. По умолчанию EXHAUSTIVE: MAX_SCORE выигрывает
+// только на коротких запросах и медленнее на длинных запросах и при фильтре по статусу
+enum class QueryEvaluation {
+    EXHAUSTIVE,
+    MAX_SCORE,
+};
+
+// Относительный запас верхних границ релевантности в MAX_SCORE:
+// покрывает погрешность сложения вкладов слов в другом порядке
+const double MAX_SCORE_BOUND_SLACK = 1e-9;
+
 class SearchServer {
 public:
     template <typename StringContainer>
@@ -27,30 +97,64 @@ public:
     explicit SearchServer(std::string_view stop_words_text);
 
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    // Пакетное добавление документов. Индекс получается таким же, как после
+    // последовательных вызовов AddDocument в порядке documents. При ошибке
+    // в любом из документов выбрасывается исключение и сервер не изменяется
+    void AddDocuments(const std::vector<NewDocument>& documents);
+
+    void AddDocuments(const std::execution::sequenced_policy& policy, const std::vector<NewDocument>& documents);
+
+    // Параллельная версия пакетного добавления: документы разбиваются на слова
+    // параллельно, каждая задача строит частичный индекс своей части документов,
+    // затем частичные индексы объединяются с основным за один проход
+    void AddDocuments(const std::execution::parallel_policy& policy, const std::vector<NewDocument>& documents);
     void PrintDocument(int document_id);
    
+    // top_count - количество документов в выдаче, для постраничного вывода
+    // можно запросить сразу несколько страниц
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
     // Последовательная явная версия поиска топ-документов
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy& policy,
-        std::string_view raw_query, DocumentPredicate document_predicate) const;
+        std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
     // Последовательная явная версия поиска топ-документов
     std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy& policy,
-        std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL) const;
+        std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
     // Параллельная версия поиска топ-документов
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(const std::execution::parallel_policy& policy, 
-        std::string_view raw_query, DocumentPredicate document_predicate) const;
+        std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
     // Параллельная версия поиска документов
     std::vector<Document> FindTopDocuments(const std::execution::parallel_policy& policy,
-        std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL) const;
+        std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    // Поиск среди документов со статусом status и рейтингом из [min_rating, max_rating].
+    // Фильтр строится по битовым массивам статусов и индексу рейтингов, без вызова
+    // предиката для каждого документа. Результаты не кешируются
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+        int min_rating, int max_rating, size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    std::vector<Document> FindTopDocuments(const std::execution::sequenced_policy& policy,
+        std::string_view raw_query, DocumentStatus status,
+        int min_rating, int max_rating, size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    std::vector<Document> FindTopDocuments(const std::execution::parallel_policy& policy,
+        std::string_view raw_query, DocumentStatus status,
+        int min_rating, int max_rating, size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
     // Возвращает количество документов
     int GetDocumentCount() const;
@@ -59,8 +163,9 @@ public:
 
     std::set<int>::const_iterator end() const;
 
-    //Метод получения частот слов по id документа
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    // Метод получения частот слов по id документа: слова по алфавиту, пусто для
+    // несуществующего документа. Представление действительно до удаления документов
+    WordFrequencies GetWordFrequencies(int document_id) const;
 
     //Метод удаления документов из поискового сервера
     void RemoveDocument(int document_id);
@@ -78,218 +183,637 @@ public:
 
     MyTuple MatchDocument(const std::execution::parallel_policy& policy, const std::string_view raw_query, int document_id) const;
 
+    // Пакетная версия MatchDocument, например для подсветки слов страницы выдачи:
+    // запрос разбирается один раз, результат для document_ids[i] записывается
+    // в matches под номером i. Если документа нет, до проверки документов
+    // выбрасывается исключение std::out_of_range
+    void MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids,
+        DocumentMatches& matches) const;
+
+    void MatchDocuments(const std::execution::sequenced_policy& policy, std::string_view raw_query,
+        const std::vector<int>& document_ids, DocumentMatches& matches) const;
+
+    // Параллельная версия: документы пакета проверяются задачами пула потоков сервера
+    void MatchDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query,
+        const std::vector<int>& document_ids, DocumentMatches& matches) const;
+
+    // Средний рейтинг документа, 0 без оценок
+    static int ComputeAverageRating(const std::vector<int>& ratings);
+
+    // Статистика хранилища: живые и мертвые байты слов, порядковых номеров документов
+    // и прямого индекса.
+    // Мертвые байты остаются от удаленных документов до уплотнения
+    struct StorageStats {
+        size_t live_bytes;
+        size_t dead_bytes;
+        size_t live_word_bytes;
+        size_t dead_word_bytes;
+        size_t removed_document_count;
+    };
+
+    StorageStats GetStorageStats() const;
+
+    // Освобождает память удаленных слов и документов.
+    // Вызывается автоматически, когда мертвых байт становится больше живых.
+    // Делает недействительными ссылки на слова, полученные ранее из GetWordFrequencies
+    void Compact();
+
+    // Сохраняет индекс в двоичный снимок: стоп-слова, словарь, списки документов,
+    // рейтинги, статусы и частоты слов документов. Тексты документов сервер не хранит.
+    // Выбрасывает std::runtime_error при ошибке записи
+    void SaveSnapshot(const std::string& path) const;
+
+    // Создает сервер из снимка без разбиения текстов на слова. Файл отображается в память,
+    // и сервер работает прямо с отображением: слова, хеш-таблица словаря, списки документов
+    // и частоты слов документов не копируются, а проверяются при загрузке. Копируются только
+    // данные документов (id, рейтинги, статусы). Список документов слова или прямой индекс
+    // копируется в память сервера перед первым изменением, словарь строится заново перед
+    // первым добавлением или удалением слова. Файл снимка нельзя изменять, пока сервер жив.
+    // Выбрасывает std::runtime_error, если файл не удалось прочитать, он не является снимком
+    // текущей версии или ссылается на несуществующие либо удаленные документы
+    static SearchServer LoadSnapshot(const std::string& path);
+
+    // Выбор способа накопления релевантности в параллельном поиске
+    void SetParallelAccumulation(ParallelAccumulation accumulation);
+
+    ParallelAccumulation GetParallelAccumulation() const;
+
+    // Выбор формата списков документов: сжатые списки занимают в несколько раз меньше
+    // памяти и распаковываются блоками при поиске. Результаты поиска не зависят от формата
+    void SetPostingsFormat(PostingsFormat format);
+
+    PostingsFormat GetPostingsFormat() const;
+
+    // Выбор способа отбора лучших документов в последовательном поиске
+    void SetQueryEvaluation(QueryEvaluation evaluation);
+
+    QueryEvaluation GetQueryEvaluation() const;
+
+    // Кеш результатов последовательного поиска по статусу документов. Ключ - запрос после
+    // разбора (плюс- и минус-слова отсортированы, без повторов), статус и размер выдачи.
+    // Добавление и удаление документов делают записи кеша устаревшими.
+    // Емкость 0 (по умолчанию) выключает кеш. Поиск с предикатом не кешируется.
+    // Копия сервера получает пустой кеш той же емкости
+    void SetResultCacheCapacity(size_t capacity);
+
+    QueryResultCache::Stats GetResultCacheStats() const;
+
+    // Пул потоков параллельных версий методов. По умолчанию - общий пул по количеству
+    // ядер; копия сервера использует тот же пул
+    void SetThreadPool(std::shared_ptr<ThreadPool> thread_pool);
+
+    ThreadPool& GetThreadPool() const;
+
+    // Гистограммы времени этапов обработки (разбиение документов, разбор запроса, обход
+    // списков, расчет релевантности, минус-слова, отбор) и счетчики всех серверов процесса
+    // с последнего ResetStats. Собираются только при сборке с SEARCH_SERVER_STATS
+    static SearchStatsSnapshot GetStatsSnapshot();
+
+    static void ResetStats();
+
 private:
+    // Пустой сервер для загрузки снимка
+    SearchServer() = default;
+
     // Данные документа:
-    // rating - рейтинг;
-    // status - статус;
+    // ordinal - порядковый номер документа в инвертированном индексе.
+    // Рейтинг и статус хранятся по номеру документа в document_columns_
     struct DocumentData {
-        int rating;
-        DocumentStatus status;
+        int ordinal;
     };
 
-    // Список стоп-слов
-    const std::set<std::string, std::less<>> stop_words_;
+    // Разбор документов и запросов со списком стоп-слов
+    TextAnalyzer text_analyzer_;
 
-    // Список слов и их частот для каждого документа
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+    // Номера слов и их частоты для каждого порядкового номера документа
+    ForwardIndex document_to_word_freqs_;
 
     // Список документов и частот для каждого слова
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
+    InvertedIndex word_to_document_freqs_;
 
-    // Список рейтингов и статусов для каждого документа
+    // Данные каждого документа
     std::map<int, DocumentData> documents_;
 
+    // Рейтинги и статусы документов по порядковым номерам
+    DocumentColumns document_columns_;
+
     // Список id документов
     std::set<int> document_ids_;
 
-    // Временное хранилище документа
-    std::deque<std::string> storage_;
+    // id документа для каждого порядкового номера, -1 для удаленных документов
+    std::vector<int> ordinal_to_document_id_;
 
-    bool IsStopWord(std::string_view word) const;
+    ParallelAccumulation parallel_accumulation_ = ParallelAccumulation::PARTIAL_TABLES;
 
-    static bool IsValidWord(std::string_view word);
+    QueryEvaluation query_evaluation_ = QueryEvaluation::EXHAUSTIVE;
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string& text) const;
+    // Поколение индекса, увеличивается при каждом добавлении и удалении документов
+    uint64_t index_generation_ = 0;
 
-    static int ComputeAverageRating(const std::vector<int>& ratings);
+    mutable QueryResultCache result_cache_;
 
-    struct QueryWord {
-        std::string_view data;
-        bool is_minus;
-        bool is_stop;
-    };
+    std::shared_ptr<ThreadPool> thread_pool_ = ThreadPool::GetDefault();
 
-    QueryWord ParseQueryWord(std::string_view text) const;
+    using WordFreqs = TextAnalyzer::WordFreqs;
 
-    struct Query {
-        std::vector<std::string_view> plus_words;
-        std::vector<std::string_view> minus_words;
-    };
+    // Проверяет id документа перед добавлением
+    void CheckNewDocumentId(int document_id) const;
+
+    template <typename ExecutionPolicy>
+    void AddDocumentsImpl(ExecutionPolicy&& policy, const std::vector<NewDocument>& documents);
+
+    template <typename ExecutionPolicy>
+    void MatchDocumentsImpl(ExecutionPolicy&& policy, const TextAnalyzer::Query& query,
+        const std::vector<int>& document_ids, DocumentMatches& matches) const;
+
+    // Вызывает func(i) для i из [0, count): последовательно или в пуле потоков сервера
+    template <typename Func>
+    void ForEachIndex(const std::execution::sequenced_policy&, size_t count, Func func) const;
+
+    template <typename Func>
+    void ForEachIndex(const std::execution::parallel_policy&, size_t count, Func func) const;
+
+
+    // Уплотняет хранилище, если мертвых байт больше живых
+    void CompactIfNeeded();
+
+    using Query = TextAnalyzer::Query;
+
+    // Логарифм количества документов, обновляется при добавлении и удалении документов
+    double log_document_count_ = 0.0;
 
-    // Разбивает запрос на плюс- и минус-слова
-    Query ParseQuery(std::string_view text, const bool remove_duplicates = true) const;
+    // IDF = log(N / df) = log(N) - log(df), оба логарифма поддерживаются заранее
+    double ComputeWordInverseDocumentFreq(const PostingList& postings) const;
 
-    // Existence required
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    // Накопитель релевантности текущего потока для последовательного поиска
+    static RelevanceAccumulator& GetThreadAccumulator();
 
+    // Общий пул накопителей релевантности для задач параллельного поиска
+    static ConcurrentPool<RelevanceAccumulator>& GetAccumulatorPool();
+
+    // Курсоры по спискам минус-слов запроса
+    MinusWordFilter MakeMinusWordFilter(const Query& query) const;
+
+    // Фильтр номеров документов для предиката от id, статуса и рейтинга документа.
+    // Внутренние методы поиска принимают фильтры номеров: document_filter(ordinal) == true
+    // для документов, которые могут попасть в выдачу
     template <typename DocumentPredicate>
+    auto MakePredicateFilter(DocumentPredicate& document_predicate) const;
+
+    // Вызывает add_relevance(ordinal, relevance) для каждого документа со словом word,
+    // который проходит фильтр и не содержит минус-слов.
+    // Список документов слова проходится вместе со списками минус-слов
+    template <typename DocumentFilter, typename AddRelevance>
+    void AddWordRelevance(std::string_view word, MinusWordFilter& minus_words,
+        DocumentFilter& document_filter, AddRelevance add_relevance) const;
+
+    template <typename DocumentFilter>
     std::vector<Document> FindAllDocuments(const Query& query,
-        DocumentPredicate document_predicate) const;
+        DocumentFilter document_filter) const;
 
-    template <typename DocumentPredicate>
+    template <typename DocumentFilter>
     std::vector<Document> FindAllDocuments(const std::execution::parallel_policy& policy,
-        const Query& query, DocumentPredicate document_predicate) const;
+        const Query& query, DocumentFilter document_filter) const;
+
+    // Отбор лучших документов по разобранному запросу
+    template <typename DocumentFilter>
+    std::vector<Document> FindTopDocumentsForQuery(const Query& query,
+        DocumentFilter document_filter, size_t top_count) const;
+
+    // Параллельный отбор лучших документов по разобранному запросу
+    template <typename DocumentFilter>
+    std::vector<Document> FindTopDocumentsForQuery(const std::execution::parallel_policy& policy,
+        const Query& query, DocumentFilter document_filter, size_t top_count) const;
+
+    // Ключ кеша результатов для разобранного запроса
+    static void MakeResultCacheKey(const Query& query, DocumentStatus status, size_t top_count, std::string& key);
+
+    // Отбор лучших документов алгоритмом MaxScore
+    template <typename DocumentFilter>
+    std::vector<Document> FindTopDocumentsMaxScore(const Query& query,
+        DocumentFilter document_filter, size_t top_count) const;
+
+    // Добавляет в top_documents документы с номерами из [begin_ordinal, end_ordinal),
+    // отобранные алгоритмом MaxScore. shared_threshold - порог выдачи, общий для задач
+    // параллельного поиска по разным диапазонам, или nullptr
+    template <typename DocumentFilter>
+    void AddTopDocumentsMaxScore(const Query& query, DocumentFilter& document_filter,
+        int begin_ordinal, int end_ordinal, TopDocuments& top_documents,
+        std::atomic<double>* shared_threshold) const;
+
+    // Выбран DOCUMENT_RANGES, запрос короткий и индекс делится хотя бы на два диапазона
+    bool UseDocumentRanges(const Query& query) const;
+
+    // Параллельный отбор лучших документов по диапазонам номеров документов
+    template <typename DocumentFilter>
+    std::vector<Document> FindTopDocumentsByRanges(const Query& query,
+        DocumentFilter document_filter, size_t top_count) const;
 };
 
 template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words)
-    : stop_words_(
-        MakeUniqueNonEmptyStrings(stop_words))  // Extract non-empty stop words
-{
-    if (!std::all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
-        using namespace std::string_literals;
-        throw std::invalid_argument("Some of stop words are invalid"s);
+    : text_analyzer_(stop_words) {
+}
+
+template <typename Func>
+void SearchServer::ForEachIndex(const std::execution::sequenced_policy&, size_t count, Func func) const {
+    for (size_t i = 0; i < count; ++i) {
+        func(i);
     }
 }
 
+template <typename Func>
+void SearchServer::ForEachIndex(const std::execution::parallel_policy&, size_t count, Func func) const {
+    thread_pool_->ParallelFor(count, func);
+}
+
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
-    DocumentPredicate document_predicate) const {
-    auto query = ParseQuery(raw_query);
+    DocumentPredicate document_predicate, size_t top_count) const {
+    Query& query = TextAnalyzer::GetThreadQuery();
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        text_analyzer_.ParseQuery(raw_query, query);
+    }
+    return FindTopDocumentsForQuery(query, MakePredicateFilter(document_predicate), top_count);
+}
 
-    auto matched_documents = FindAllDocuments(query, document_predicate);
+template <typename DocumentFilter>
+std::vector<Document> SearchServer::FindTopDocumentsForQuery(const Query& query,
+    DocumentFilter document_filter, size_t top_count) const {
+    SearchStats::Add(SearchCounter::QUERIES);
+    if (query_evaluation_ == QueryEvaluation::MAX_SCORE) {
+        return FindTopDocumentsMaxScore(query, document_filter, top_count);
+    }
 
-    sort(matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < std::numeric_limits<double>::epsilon()) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
-        });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    const std::vector<Document> matched_documents = FindAllDocuments(query, document_filter);
+
+    // Отбираем лучшие документы без сортировки всех найденных
+    SearchStageTimer timer(SearchStage::RANKING);
+    TopDocuments top_documents(top_count);
+    for (const Document& document : matched_documents) {
+        top_documents.Add(document);
     }
-    return matched_documents;
+    return top_documents.Build();
 }
 
 // Последовательная явная версия поиска топ-документов
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy& policy,
-    std::string_view raw_query, DocumentPredicate document_predicate) const {
-    return FindTopDocuments(raw_query, document_predicate);
+std::vector<Document> SearchServer::FindTopDocuments(const std::execution::sequenced_policy&,
+    std::string_view raw_query, DocumentPredicate document_predicate, size_t top_count) const {
+    return FindTopDocuments(raw_query, document_predicate, top_count);
 }
 
 // Параллельная версия поиска топ-документов
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(const std::execution::parallel_policy& policy,
-    std::string_view raw_query, DocumentPredicate document_predicate) const {
-    auto query = ParseQuery(raw_query);
+    std::string_view raw_query, DocumentPredicate document_predicate, size_t top_count) const {
+    Query query;
+    {
+        SearchStageTimer timer(SearchStage::PARSE_QUERY);
+        query = text_analyzer_.ParseQuery(raw_query);
+    }
+    return FindTopDocumentsForQuery(policy, query, MakePredicateFilter(document_predicate), top_count);
+}
 
-    std::vector<Document> matched_documents;
+template <typename DocumentFilter>
+std::vector<Document> SearchServer::FindTopDocumentsForQuery(const std::execution::parallel_policy& policy,
+    const Query& query, DocumentFilter document_filter, size_t top_count) const {
+    SearchStats::Add(SearchCounter::QUERIES);
+    if (UseDocumentRanges(query)) {
+        return FindTopDocumentsByRanges(query, document_filter, top_count);
+    }
 
-    matched_documents = FindAllDocuments(policy, query, document_predicate);
-    
-    std::sort(policy, matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < std::numeric_limits<double>::epsilon()) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
+    const std::vector<Document> matched_documents = FindAllDocuments(policy, query, document_filter);
+
+    // Каждый поток отбирает лучшие документы своей части, затем результаты объединяются
+    SearchStageTimer timer(SearchStage::RANKING);
+    const size_t part_count = thread_pool_->GetThreadCount();
+    const size_t part_size = (matched_documents.size() + part_count - 1) / part_count;
+    std::vector<TopDocuments> part_top_documents(part_count, TopDocuments(top_count));
+
+    ForEachIndex(policy, part_count,
+        [&](size_t part) {
+            const size_t part_begin = std::min(part * part_size, matched_documents.size());
+            const size_t part_end = std::min(part_begin + part_size, matched_documents.size());
+            for (size_t i = part_begin; i < part_end; ++i) {
+                part_top_documents[part].Add(matched_documents[i]);
             }
         });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+
+    TopDocuments top_documents(top_count);
+    for (const auto& part_top : part_top_documents) {
+        top_documents.Merge(part_top);
     }
-    
-    return matched_documents;
+    return top_documents.Build();
 }
 
-// Последовательная версия поиска документов
 template <typename DocumentPredicate>
+auto SearchServer::MakePredicateFilter(DocumentPredicate& document_predicate) const {
+    return [this, &document_predicate](int ordinal) {
+        return document_predicate(ordinal_to_document_id_[ordinal],
+            document_columns_.GetStatus(ordinal), document_columns_.GetRating(ordinal));
+    };
+}
+
+// Последовательная версия поиска документов
+template <typename DocumentFilter>
 std::vector<Document> SearchServer::FindAllDocuments(const Query& query,
-    DocumentPredicate document_predicate) const {
-
-    std::map<int, double> document_to_relevance;
-    for (std::string_view word : query.plus_words) {
-        // Обрабатываем только те плюс-слова, что имеются в списке слов
-        if (word_to_document_freqs_.count(word) != 0) {
-
-            // Рассчитываем IDF частоту слова
-            const double inverse_document_freq = SearchServer::ComputeWordInverseDocumentFreq(word);
-            // для каждого слова имеющего id и частоту freq в документе
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
-                }
-            }
+    DocumentFilter document_filter) const {
+
+    RelevanceAccumulator& accumulator = GetThreadAccumulator();
+    accumulator.Reset();
+    accumulator.Resize(ordinal_to_document_id_.size());
+
+    MinusWordFilter minus_words = MakeMinusWordFilter(query);
+    {
+        SearchStageTimer timer(SearchStage::POSTINGS);
+        for (std::string_view word : query.plus_words) {
+            AddWordRelevance(word, minus_words, document_filter,
+                [&accumulator](int ordinal, double relevance) {
+                    accumulator.Add(ordinal, relevance);
+                });
         }
     }
 
-    for (std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) != 0) {
+    SearchStageTimer timer(SearchStage::SCORING);
+    SearchStats::Add(SearchCounter::DOCUMENTS_SCORED, accumulator.GetTouchedCount());
+    std::vector<Document> matched_documents;
+    matched_documents.reserve(accumulator.GetTouchedCount());
+    accumulator.ForEach([&](int ordinal, double relevance) {
+        matched_documents.push_back(
+            { ordinal_to_document_id_[ordinal], relevance, document_columns_.GetRating(ordinal) });
+    });
+    accumulator.Reset();
+    return matched_documents;
+}
 
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
-            }
+// Параллельная версия поиска документов
+template <typename DocumentFilter>
+std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy& policy,
+    const Query& query, DocumentFilter document_filter) const {
+
+    // Накопитель итоговой релевантности берется из пула, а не из потока:
+    // поток может выполнять задачи других запросов, пока ждет завершения своих
+    auto& pool = GetAccumulatorPool();
+    auto accumulator = pool.Acquire();
+    accumulator->Reset();
+    accumulator->Resize(ordinal_to_document_id_.size());
+
+    std::optional<SearchStageTimer> postings_timer(std::in_place, SearchStage::POSTINGS);
+    if (parallel_accumulation_ == ParallelAccumulation::CONCURRENT_MAP) {
+        ConcurrentMap<int, double> ordinal_to_relevance(CONCURRENT_MAP_BUCKET_COUNT);
+
+        // Обрабатываем слова из списка плюс-слов
+        ForEachIndex(policy, query.plus_words.size(),
+            [&](size_t i) {
+                MinusWordFilter minus_words = MakeMinusWordFilter(query);
+                AddWordRelevance(query.plus_words[i], minus_words, document_filter,
+                    [&ordinal_to_relevance](int ordinal, double relevance) {
+                        ordinal_to_relevance[ordinal].ref_to_value += relevance;
+                    });
+            });
+
+        for (const auto [ordinal, relevance] : ordinal_to_relevance.BuildOrdinaryMap()) {
+            accumulator->Add(ordinal, relevance);
         }
     }
+    else {
+        // Плюс-слова делятся между задачами, каждая задача накапливает
+        // релевантность в собственном массиве
+        const size_t part_count = std::min<size_t>(query.plus_words.size(),
+            thread_pool_->GetThreadCount());
+        std::vector<ConcurrentPool<RelevanceAccumulator>::Handle> part_accumulators(part_count);
+
+        ForEachIndex(policy, part_count,
+            [&](size_t part) {
+                auto part_accumulator = pool.Acquire();
+                part_accumulator->Reset();
+                part_accumulator->Resize(ordinal_to_document_id_.size());
+                MinusWordFilter minus_words = MakeMinusWordFilter(query);
+                for (size_t i = part; i < query.plus_words.size(); i += part_count) {
+                    AddWordRelevance(query.plus_words[i], minus_words, document_filter,
+                        [&part_accumulator](int ordinal, double relevance) {
+                            part_accumulator->Add(ordinal, relevance);
+                        });
+                }
+                part_accumulators[part] = std::move(part_accumulator);
+            });
+
+        // Объединяем частичные результаты
+        for (const auto& part_accumulator : part_accumulators) {
+            part_accumulator->ForEach([&accumulator](int ordinal, double relevance) {
+                accumulator->Add(ordinal, relevance);
+            });
+            part_accumulator->Reset();
+        }
+    }
+
+    postings_timer.reset();
 
+	// Формируем итоговый список найденных документов
+    SearchStageTimer timer(SearchStage::SCORING);
+    SearchStats::Add(SearchCounter::DOCUMENTS_SCORED, accumulator->GetTouchedCount());
     std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
+    matched_documents.reserve(accumulator->GetTouchedCount());
+    accumulator->ForEach([&](int ordinal, double relevance) {
         matched_documents.push_back(
-            { document_id, relevance, documents_.at(document_id).rating });
-    }
+            { ordinal_to_document_id_[ordinal], relevance, document_columns_.GetRating(ordinal) });
+    });
+    accumulator->Reset();
     return matched_documents;
 }
 
-// Параллельная версия поиска документов
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy& policy,
-    const Query& query, DocumentPredicate document_predicate) const {
-
-    ConcurrentMap<int, double> document_to_relevance(query.plus_words.size());
-    std::set<int> id_of_minus_word;
-    
-	// Определяем список id документов, содержащих минус-слова
-    for_each(query.minus_words.begin(), query.minus_words.end(),
-        [&](const std::string_view word) {
-
-            if (word_to_document_freqs_.count(word) != 0)
-                for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                    id_of_minus_word.insert(document_id);
-                }
+// MaxScore: слова запроса упорядочены по верхней границе вклада в релевантность.
+// Слова, сумма границ которых не выше порога выдачи, необязательные: документ только
+// с ними не попадет в выдачу. Кандидаты берутся из списков обязательных слов,
+// необязательные слова проверяются от большего вклада к меньшему, пока документ
+// еще может превысить порог. С ростом порога обязательных слов становится меньше
+template <typename DocumentFilter>
+std::vector<Document> SearchServer::FindTopDocumentsMaxScore(const Query& query,
+    DocumentFilter document_filter, size_t top_count) const {
+    TopDocuments top_documents(top_count);
+    AddTopDocumentsMaxScore(query, document_filter, 0, PostingCursor::END, top_documents, nullptr);
+    SearchStageTimer timer(SearchStage::RANKING);
+    return top_documents.Build();
+}
+
+template <typename DocumentFilter>
+std::vector<Document> SearchServer::FindTopDocumentsByRanges(const Query& query,
+    DocumentFilter document_filter, size_t top_count) const {
+    const int ordinal_count = static_cast<int>(ordinal_to_document_id_.size());
+    const size_t range_count = std::clamp<size_t>(ordinal_count / MIN_DOCUMENT_RANGE_SIZE,
+        1, thread_pool_->GetThreadCount());
+    std::vector<TopDocuments> range_top_documents(range_count, TopDocuments(top_count));
+
+    // K-я релевантность любого диапазона не больше K-й релевантности всей выдачи,
+    // поэтому лучший из порогов диапазонов отсекает документы во всех диапазонах
+    std::atomic<double> shared_threshold = -std::numeric_limits<double>::infinity();
+    ForEachIndex(std::execution::par, range_count,
+        [&](size_t range) {
+            const int begin_ordinal = static_cast<int>(ordinal_count * range / range_count);
+            const int end_ordinal = static_cast<int>(ordinal_count * (range + 1) / range_count);
+            AddTopDocumentsMaxScore(query, document_filter, begin_ordinal, end_ordinal,
+                range_top_documents[range], &shared_threshold);
         });
 
-	// Обрабатываем слова из списка плюс-слов
-    std::for_each(policy, query.plus_words.begin(), query.plus_words.end(),
-        [&](const std::string_view& word) {
-            if (word_to_document_freqs_.count(word) != 0) {
-
-                const double inverse_document_freq = SearchServer::ComputeWordInverseDocumentFreq(word);
-                
-                for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                    // Игнорируем документы, которые содержат минус-слова
-					if (id_of_minus_word.count(document_id)) { continue; }
-                    
-                    const auto& document_data = documents_.at(document_id);
-                    if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                       document_to_relevance[document_id].ref_to_value  += term_freq * inverse_document_freq;
-                    }
+    SearchStageTimer timer(SearchStage::RANKING);
+    TopDocuments top_documents(top_count);
+    for (const auto& range_top : range_top_documents) {
+        top_documents.Merge(range_top);
+    }
+    return top_documents.Build();
+}
+
+template <typename DocumentFilter>
+void SearchServer::AddTopDocumentsMaxScore(const Query& query, DocumentFilter& document_filter,
+    int begin_ordinal, int end_ordinal, TopDocuments& top_documents,
+    std::atomic<double>* shared_threshold) const {
+    struct QueryTerm {
+        PostingCursor cursor;
+        double inverse_document_freq;
+        double max_relevance;
+        // Номер слова в query.plus_words
+        size_t word_index;
+    };
+    std::vector<QueryTerm> terms;
+    terms.reserve(query.plus_words.size());
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        const PostingList* postings = word_to_document_freqs_.Find(query.plus_words[i]);
+        if (postings != nullptr) {
+            const double inverse_document_freq = ComputeWordInverseDocumentFreq(*postings);
+            terms.push_back({ PostingCursor(word_to_document_freqs_, *postings), inverse_document_freq,
+                postings->max_term_freq * inverse_document_freq, i });
+            terms.back().cursor.Advance(begin_ordinal);
+        }
+    }
+    std::sort(terms.begin(), terms.end(), [](const QueryTerm& lhs, const QueryTerm& rhs) {
+        return lhs.max_relevance < rhs.max_relevance;
+    });
+    // max_relevances[i] - сумма верхних границ вклада слов terms[0..i]
+    std::vector<double> max_relevances(terms.size());
+    double max_relevance = 0.0;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        max_relevance += terms[i].max_relevance;
+        max_relevances[i] = max_relevance;
+    }
+
+    // Кандидаты идут по возрастанию номеров, поэтому минус-слова проверяются за один проход
+    MinusWordFilter minus_words = MakeMinusWordFilter(query);
+
+    // Вклады слов в релевантность кандидата складываются в порядке слов запроса,
+    // как при полном переборе, поэтому релевантность совпадает до бита
+    std::vector<double> word_relevances(query.plus_words.size(), 0.0);
+    SearchStageTimer timer(SearchStage::POSTINGS);
+    LocalSearchCounter scanned_count(SearchCounter::POSTINGS_SCANNED);
+    LocalSearchCounter scored_count(SearchCounter::DOCUMENTS_SCORED);
+    LocalSearchCounter excluded_count(SearchCounter::DOCUMENTS_EXCLUDED);
+    size_t first_essential = 0;
+    while (true) {
+        double threshold = top_documents.GetThreshold();
+        if (shared_threshold != nullptr) {
+            threshold = std::max(threshold, shared_threshold->load(std::memory_order_relaxed));
+        }
+        const auto can_enter = [threshold](double relevance_bound) {
+            return relevance_bound * (1.0 + MAX_SCORE_BOUND_SLACK) > threshold;
+        };
+        while (first_essential < terms.size() && !can_enter(max_relevances[first_essential])) {
+            ++first_essential;
+        }
+        int ordinal = PostingCursor::END;
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            ordinal = std::min(ordinal, terms[i].cursor.GetOrdinal());
+        }
+        if (ordinal >= end_ordinal) {
+            break;
+        }
+
+        // Фильтр проверяется до минус-слов и расчета релевантности:
+        // отброшенный документ только сдвигает курсоры обязательных слов
+        const bool is_filtered_out = !document_filter(ordinal);
+        const bool is_excluded = !is_filtered_out && minus_words.IsExcluded(ordinal);
+        double relevance = 0.0;
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            QueryTerm& term = terms[i];
+            if (term.cursor.GetOrdinal() == ordinal) {
+                if (!is_filtered_out && !is_excluded) {
+                    const double word_relevance = term.cursor.GetTermFreq() * term.inverse_document_freq;
+                    word_relevances[term.word_index] = word_relevance;
+                    relevance += word_relevance;
                 }
+                term.cursor.Next();
+                scanned_count.Add();
             }
-        });
+        }
+        if (is_excluded) {
+            excluded_count.Add();
+        }
+        if (is_filtered_out || is_excluded) {
+            continue;
+        }
 
-	// Формируем итоговый список найденных документов
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
-        matched_documents.push_back(
-            { document_id, relevance, documents_.at(document_id).rating });
+        bool is_candidate = true;
+        for (size_t i = first_essential; i-- > 0;) {
+            if (!can_enter(relevance + max_relevances[i])) {
+                is_candidate = false;
+                break;
+            }
+            QueryTerm& term = terms[i];
+            term.cursor.Advance(ordinal);
+            if (term.cursor.GetOrdinal() == ordinal) {
+                const double word_relevance = term.cursor.GetTermFreq() * term.inverse_document_freq;
+                word_relevances[term.word_index] = word_relevance;
+                relevance += word_relevance;
+            }
+        }
+        if (is_candidate) {
+            double document_relevance = 0.0;
+            for (const double word_relevance : word_relevances) {
+                document_relevance += word_relevance;
+            }
+            top_documents.Add({ ordinal_to_document_id_[ordinal], document_relevance,
+                document_columns_.GetRating(ordinal) });
+            scored_count.Add();
+            if (shared_threshold != nullptr) {
+                const double range_threshold = top_documents.GetThreshold();
+                double threshold = shared_threshold->load(std::memory_order_relaxed);
+                while (range_threshold > threshold
+                    && !shared_threshold->compare_exchange_weak(threshold, range_threshold, std::memory_order_relaxed)) {
+                }
+            }
+        }
+        std::fill(word_relevances.begin(), word_relevances.end(), 0.0);
     }
-    return matched_documents;
+}
+
+template <typename DocumentFilter, typename AddRelevance>
+void SearchServer::AddWordRelevance(std::string_view word, MinusWordFilter& minus_words,
+    DocumentFilter& document_filter, AddRelevance add_relevance) const {
+    // Обрабатываем только те плюс-слова, что имеются в списке слов
+    const PostingList* postings = word_to_document_freqs_.Find(word);
+    if (postings == nullptr) {
+        return;
+    }
+
+    // Рассчитываем IDF частоту слова
+    const double inverse_document_freq = SearchServer::ComputeWordInverseDocumentFreq(*postings);
+    minus_words.Rewind();
+    SearchStats::Add(SearchCounter::POSTINGS_SCANNED, postings->size());
+    LocalSearchCounter excluded_count(SearchCounter::DOCUMENTS_EXCLUDED);
+    // для каждого документа, содержащего слово с частотой term_freq
+    word_to_document_freqs_.ForEachPosting(*postings, [&](int ordinal, double term_freq) {
+        // Фильтр дешевле проверки минус-слов: курсоры минус-слов
+        // сдвигаются только для документов, прошедших фильтр
+        if (!document_filter(ordinal)) {
+            return;
+        }
+        // Игнорируем документы, которые содержат минус-слова
+        if (minus_words.IsExcluded(ordinal)) {
+            excluded_count.Add();
+            return;
+        }
+        add_relevance(ordinal, term_freq * inverse_document_freq);
+    });
 }
 
 void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status,
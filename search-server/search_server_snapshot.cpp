@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+#include "mapped_file.h"
+
+using namespace std::string_literals;
+
+// Формат снимка (версия 3), порядок байт и выравнивание - как у платформы записи.
+// После заголовка идут разделы, каждый выровнен на 8 байт:
+// 1. строки: стоп-слова, затем слова словаря, без разделителей;
+// 2. стоп-слова: StringRef[stop_word_count];
+// 3. слова: WordEntry[word_count], списки документов слов идут подряд в этом же порядке.
+//    Позиция слова в разделе - его номер в словаре загруженного индекса;
+// 4. словарь: ячейки хеш-таблицы InvertedIndex::BuildDictionarySlots, uint32_t[dictionary_slot_count];
+// 5. порядковые номера документов списков: int32_t[posting_count];
+// 6. частоты слов списков: double[posting_count];
+// 7. id документа для каждого порядкового номера: int32_t[ordinal_count];
+// 8. документы: DocumentEntry[document_count];
+// 9. номера слов документов: uint32_t[forward_entry_count], подряд для каждого документа;
+// 10. частоты слов документов: double[forward_entry_count].
+// Разделы 4-6, 9 и 10 загруженный сервер использует прямо из отображенного файла
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = { 'S', 'R', 'C', 'H', 'S', 'N', 'A', 'P' };
+constexpr uint32_t SNAPSHOT_VERSION = 3;
+// Записывается в порядке байт платформы, позволяет отличить снимок с другим порядком байт
+constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+constexpr size_t SNAPSHOT_ALIGNMENT = 8;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t string_bytes;
+    uint64_t stop_word_count;
+    uint64_t word_count;
+    uint64_t dictionary_slot_count;
+    uint64_t posting_count;
+    uint64_t ordinal_count;
+    uint64_t document_count;
+    uint64_t forward_entry_count;
+};
+
+// Заголовок занимает целое число шагов выравнивания, первый раздел начинается сразу за ним
+static_assert(sizeof(SnapshotHeader) % SNAPSHOT_ALIGNMENT == 0);
+
+struct StringRef {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct WordEntry {
+    StringRef word;
+    uint64_t document_count;
+};
+
+// word_count - количество различных слов документа (записей разделов 9 и 10),
+// total_word_count - количество слов документа без стоп-слов, по нему восстанавливаются частоты сжатых списков
+struct DocumentEntry {
+    int32_t id;
+    int32_t rating;
+    int32_t status;
+    int32_t ordinal;
+    uint64_t word_count;
+    uint64_t total_word_count;
+};
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path)
+        : path_(path)
+        , output_(path, std::ios::binary | std::ios::trunc) {
+        if (!output_) {
+            throw std::runtime_error("Cannot create snapshot file "s + path_);
+        }
+    }
+
+    template <typename T>
+    void Write(const T& value) {
+        WriteBytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void WriteArray(const T* values, size_t count) {
+        WriteBytes(values, count * sizeof(T));
+        Align();
+    }
+
+    void WriteBytes(const void* data, size_t size) {
+        output_.write(static_cast<const char*>(data), size);
+        position_ += size;
+    }
+
+    // Дополняет раздел нулями до границы выравнивания
+    void Align() {
+        static constexpr char padding[SNAPSHOT_ALIGNMENT] = {};
+        WriteBytes(padding, (SNAPSHOT_ALIGNMENT - position_ % SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT);
+    }
+
+    void Finish() {
+        output_.flush();
+        if (!output_) {
+            throw std::runtime_error("Cannot write snapshot file "s + path_);
+        }
+    }
+
+private:
+    std::string path_;
+    std::ofstream output_;
+    size_t position_ = 0;
+};
+
+// Последовательное чтение разделов отображенного файла с проверкой границ
+class SnapshotReader {
+public:
+    SnapshotReader(const MappedFile& file, const std::string& path)
+        : file_(file)
+        , path_(path) {
+    }
+
+    template <typename T>
+    T Read() {
+        T value;
+        std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Возвращает начало раздела из count элементов и переходит к следующему разделу
+    template <typename T>
+    const char* TakeArray(uint64_t count) {
+        if (count > (file_.size - position_) / sizeof(T)) {
+            Fail();
+        }
+        const char* data = Take(count * sizeof(T));
+        position_ = std::min(file_.size,
+            (position_ + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT);
+        return data;
+    }
+
+    // То же для раздела, используемого сервером без копирования: элементы читаются по указателю,
+    // поэтому начало раздела должно быть выровнено для T
+    template <typename T>
+    const T* TakeMappedArray(uint64_t count) {
+        const char* data = TakeArray<T>(count);
+        if (reinterpret_cast<uintptr_t>(data) % alignof(T) != 0) {
+            Fail();
+        }
+        return reinterpret_cast<const T*>(data);
+    }
+
+    template <typename T>
+    static T Get(const char* array, size_t index) {
+        T value;
+        std::memcpy(&value, array + index * sizeof(T), sizeof(T));
+        return value;
+    }
+
+    [[noreturn]] void Fail() const {
+        throw std::runtime_error("File "s + path_ + " is not a valid search server snapshot"s);
+    }
+
+private:
+    const char* Take(size_t size) {
+        if (size > file_.size - position_) {
+            Fail();
+        }
+        const char* data = file_.data.get() + position_;
+        position_ += size;
+        return data;
+    }
+
+    const MappedFile& file_;
+    const std::string& path_;
+    size_t position_ = 0;
+};
+
+} // namespace
+
+void SearchServer::SaveSnapshot(const std::string& path) const {
+    // Номера слов в снимке - позиции в порядке обхода словаря (по номерам слов индекса
+    // без свободных номеров), по ним документы ссылаются на слова
+    std::vector<uint32_t> word_indexes;
+
+    std::vector<StringRef> stop_words;
+    std::vector<WordEntry> words;
+    uint64_t string_bytes = 0;
+    for (const auto& entry : text_analyzer_.GetStopWords()) {
+        stop_words.push_back({ string_bytes, entry.key.size() });
+        string_bytes += entry.key.size();
+    }
+    uint64_t posting_count = 0;
+    for (const auto& [word, postings] : word_to_document_freqs_) {
+        if (postings.term_id >= word_indexes.size()) {
+            word_indexes.resize(postings.term_id + 1);
+        }
+        word_indexes[postings.term_id] = static_cast<uint32_t>(words.size());
+        words.push_back({ { string_bytes, word.size() }, postings.size() });
+        string_bytes += word.size();
+        posting_count += postings.size();
+    }
+    uint64_t forward_entry_count = 0;
+    for (const auto& [_, data] : documents_) {
+        forward_entry_count += document_to_word_freqs_.GetDocumentWordCount(data.ordinal);
+    }
+    const std::vector<uint32_t> dictionary_slots = word_to_document_freqs_.BuildDictionarySlots();
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.string_bytes = string_bytes;
+    header.stop_word_count = stop_words.size();
+    header.word_count = words.size();
+    header.dictionary_slot_count = dictionary_slots.size();
+    header.posting_count = posting_count;
+    header.ordinal_count = ordinal_to_document_id_.size();
+    header.document_count = documents_.size();
+    header.forward_entry_count = forward_entry_count;
+
+    SnapshotWriter writer(path);
+    writer.Write(header);
+
+    for (const auto& entry : text_analyzer_.GetStopWords()) {
+        writer.WriteBytes(entry.key.data(), entry.key.size());
+    }
+    for (const auto& [word, _] : word_to_document_freqs_) {
+        writer.WriteBytes(word.data(), word.size());
+    }
+    writer.Align();
+    writer.WriteArray(stop_words.data(), stop_words.size());
+    writer.WriteArray(words.data(), words.size());
+    writer.WriteArray(dictionary_slots.data(), dictionary_slots.size());
+
+    // Снимок хранит несжатые списки независимо от формата списков в памяти
+    static_assert(sizeof(int) == sizeof(int32_t));
+    for (const auto& [_, postings] : word_to_document_freqs_) {
+        word_to_document_freqs_.ForEachOrdinal(postings, [&writer](int ordinal) {
+            writer.Write(static_cast<int32_t>(ordinal));
+        });
+    }
+    writer.Align();
+    for (const auto& [_, postings] : word_to_document_freqs_) {
+        word_to_document_freqs_.ForEachPosting(postings, [&writer](int, double term_freq) {
+            writer.Write(term_freq);
+        });
+    }
+    writer.Align();
+    writer.WriteArray(ordinal_to_document_id_.data(), ordinal_to_document_id_.size());
+
+    for (const auto& [document_id, data] : documents_) {
+        writer.Write(DocumentEntry{ document_id, document_columns_.GetRating(data.ordinal),
+            static_cast<int32_t>(document_columns_.GetStatus(data.ordinal)),
+            data.ordinal, document_to_word_freqs_.GetDocumentWordCount(data.ordinal),
+            word_to_document_freqs_.GetDocumentWordCount(data.ordinal) });
+    }
+    writer.Align();
+    for (const auto& [_, data] : documents_) {
+        const size_t begin = document_to_word_freqs_.GetDocumentBegin(data.ordinal);
+        for (size_t i = 0; i < document_to_word_freqs_.GetDocumentWordCount(data.ordinal); ++i) {
+            writer.Write(word_indexes[document_to_word_freqs_.GetTermId(begin + i)]);
+        }
+    }
+    writer.Align();
+    for (const auto& [_, data] : documents_) {
+        const size_t begin = document_to_word_freqs_.GetDocumentBegin(data.ordinal);
+        for (size_t i = 0; i < document_to_word_freqs_.GetDocumentWordCount(data.ordinal); ++i) {
+            writer.Write(document_to_word_freqs_.GetTermFreq(begin + i));
+        }
+    }
+    writer.Align();
+    writer.Finish();
+}
+
+SearchServer SearchServer::LoadSnapshot(const std::string& path) {
+    const MappedFile file = MapFileForReading(path);
+    SnapshotReader reader(file, path);
+
+    const auto header = reader.Read<SnapshotHeader>();
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+        || header.byte_order != SNAPSHOT_BYTE_ORDER) {
+        reader.Fail();
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Unsupported snapshot version "s + std::to_string(header.version));
+    }
+
+    // Строки остаются в отображенном файле, арены разделяют владение отображением
+    const char* strings = reader.TakeArray<char>(header.string_bytes);
+    const std::shared_ptr<const char[]> strings_block(file.data, strings);
+    const auto get_string = [&](const StringRef& ref) {
+        if (ref.size == 0 || ref.offset > header.string_bytes || ref.size > header.string_bytes - ref.offset) {
+            reader.Fail();
+        }
+        return std::string_view(strings + ref.offset, ref.size);
+    };
+
+    const char* stop_word_refs = reader.TakeArray<StringRef>(header.stop_word_count);
+    const char* word_entries = reader.TakeArray<WordEntry>(header.word_count);
+    const uint32_t* dictionary_slots = reader.TakeMappedArray<uint32_t>(header.dictionary_slot_count);
+    const int32_t* posting_ordinals = reader.TakeMappedArray<int32_t>(header.posting_count);
+    const double* posting_term_freqs = reader.TakeMappedArray<double>(header.posting_count);
+    const char* ordinal_document_ids = reader.TakeArray<int32_t>(header.ordinal_count);
+    const char* document_entries = reader.TakeArray<DocumentEntry>(header.document_count);
+    const uint32_t* forward_term_ids = reader.TakeMappedArray<uint32_t>(header.forward_entry_count);
+    const double* forward_term_freqs = reader.TakeMappedArray<double>(header.forward_entry_count);
+    // Ячейки словаря ищутся по маске, поэтому их количество - степень двойки
+    if (header.dictionary_slot_count == 0
+        || (header.dictionary_slot_count & (header.dictionary_slot_count - 1)) != 0) {
+        reader.Fail();
+    }
+
+    SearchServer server;
+
+    std::vector<std::string_view> stop_words(header.stop_word_count);
+    for (uint64_t i = 0; i < header.stop_word_count; ++i) {
+        stop_words[i] = get_string(SnapshotReader::Get<StringRef>(stop_word_refs, i));
+    }
+    if (!server.text_analyzer_.RestoreStopWords(strings_block, stop_words)) {
+        reader.Fail();
+    }
+
+    server.ordinal_to_document_id_.resize(header.ordinal_count);
+    std::memcpy(server.ordinal_to_document_id_.data(), ordinal_document_ids, header.ordinal_count * sizeof(int32_t));
+    if (std::any_of(server.ordinal_to_document_id_.begin(), server.ordinal_to_document_id_.end(),
+            [](int document_id) { return document_id < -1; })) {
+        reader.Fail();
+    }
+    const auto live_ordinal_count = std::count_if(server.ordinal_to_document_id_.begin(),
+        server.ordinal_to_document_id_.end(), [](int document_id) { return document_id != -1; });
+    if (static_cast<uint64_t>(live_ordinal_count) != header.document_count) {
+        reader.Fail();
+    }
+    server.document_columns_.Resize(header.ordinal_count);
+
+    // Списки документов и словарь не копируются и не строятся заново: индекс ссылается
+    // на разделы отображенного файла и копирует список только перед его изменением.
+    // Номера слов выдаются по порядку раздела слов и совпадают с их позициями
+    static_assert(sizeof(int) == sizeof(int32_t));
+    std::vector<std::string_view> words(header.word_count);
+    InvertedIndex& index = server.word_to_document_freqs_;
+    index.Reserve(header.word_count);
+    size_t word_bytes = 0;
+    uint64_t posting_begin = 0;
+    for (uint64_t i = 0; i < header.word_count; ++i) {
+        const auto entry = SnapshotReader::Get<WordEntry>(word_entries, i);
+        words[i] = get_string(entry.word);
+        if (entry.document_count == 0 || entry.document_count > header.posting_count - posting_begin) {
+            reader.Fail();
+        }
+        PostingList postings;
+        postings.borrowed_ordinals = posting_ordinals + posting_begin;
+        postings.borrowed_term_freqs = posting_term_freqs + posting_begin;
+        postings.borrowed_size = entry.document_count;
+        // Документы списков должны быть живыми, иначе поиск вернет удаленный документ
+        for (size_t j = 0; j < postings.borrowed_size; ++j) {
+            const int ordinal = postings.borrowed_ordinals[j];
+            if (ordinal < 0 || static_cast<uint64_t>(ordinal) >= header.ordinal_count
+                || server.ordinal_to_document_id_[ordinal] == -1
+                || (j > 0 && ordinal <= postings.borrowed_ordinals[j - 1])) {
+                reader.Fail();
+            }
+        }
+        posting_begin += entry.document_count;
+        word_bytes += words[i].size();
+        index.Restore(words[i], std::move(postings));
+    }
+    if (posting_begin != header.posting_count) {
+        reader.Fail();
+    }
+    index.AdoptWords(strings_block, word_bytes);
+    index.AdoptDictionary(file.data, dictionary_slots, header.dictionary_slot_count);
+    server.document_to_word_freqs_.Borrow(file.data, forward_term_ids, forward_term_freqs, header.forward_entry_count);
+
+    uint64_t forward_begin = 0;
+    for (uint64_t i = 0; i < header.document_count; ++i) {
+        const auto entry = SnapshotReader::Get<DocumentEntry>(document_entries, i);
+        if (entry.status < static_cast<int32_t>(DocumentStatus::ACTUAL)
+            || entry.status > static_cast<int32_t>(DocumentStatus::REMOVED)
+            || entry.ordinal < 0 || static_cast<uint64_t>(entry.ordinal) >= header.ordinal_count
+            || server.ordinal_to_document_id_[entry.ordinal] != entry.id
+            || entry.word_count > header.forward_entry_count - forward_begin
+            || !server.documents_.emplace(entry.id, DocumentData{ entry.ordinal }).second) {
+            reader.Fail();
+        }
+        server.document_columns_.Add(entry.ordinal, static_cast<DocumentStatus>(entry.status), entry.rating);
+        server.document_ids_.emplace_hint(server.document_ids_.end(), entry.id);
+        index.SetDocumentWordCount(entry.ordinal, entry.total_word_count);
+
+        // Слова документа в снимке идут по алфавиту, как и в прямом индексе
+        for (uint64_t j = forward_begin; j < forward_begin + entry.word_count; ++j) {
+            if (forward_term_ids[j] >= header.word_count
+                || (j > forward_begin && !(words[forward_term_ids[j - 1]] < words[forward_term_ids[j]]))) {
+                reader.Fail();
+            }
+        }
+        server.document_to_word_freqs_.SetDocument(entry.ordinal, forward_begin, entry.word_count);
+        forward_begin += entry.word_count;
+    }
+    if (forward_begin != header.forward_entry_count) {
+        reader.Fail();
+    }
+    server.log_document_count_ = std::log(server.GetDocumentCount());
+    return server;
+}
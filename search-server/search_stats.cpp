@@ -0,0 +1,206 @@
+#include "search_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+using namespace std::literals;
+
+std::string_view GetSearchStageName(SearchStage stage) {
+    static constexpr std::array<std::string_view, SEARCH_STAGE_COUNT> names = {
+        "tokenize"sv, "parse_query"sv, "minus_filter"sv, "postings"sv, "scoring"sv, "ranking"sv };
+    return names[static_cast<size_t>(stage)];
+}
+
+std::string_view GetSearchCounterName(SearchCounter counter) {
+    static constexpr std::array<std::string_view, SEARCH_COUNTER_COUNT> names = {
+        "queries"sv, "postings_scanned"sv, "documents_scored"sv, "documents_excluded"sv,
+        "cache_hits"sv, "cache_misses"sv };
+    return names[static_cast<size_t>(counter)];
+}
+
+size_t LatencyHistogram::GetBucket(uint64_t nanoseconds) {
+    constexpr uint64_t sub_bucket_count = uint64_t{ 1 } << SUB_BUCKET_BITS;
+    if (nanoseconds < sub_bucket_count) {
+        return static_cast<size_t>(nanoseconds);
+    }
+#if defined(__GNUC__) || defined(__clang__)
+    const size_t high_bit = 63 - static_cast<size_t>(__builtin_clzll(nanoseconds));
+#else
+    size_t high_bit = 63;
+    while ((nanoseconds >> high_bit) == 0) {
+        --high_bit;
+    }
+#endif
+    // Старший бит задает интервал, следующие SUB_BUCKET_BITS битов - корзину в нем
+    const size_t sub_bucket = static_cast<size_t>(nanoseconds >> (high_bit - SUB_BUCKET_BITS)) & (sub_bucket_count - 1);
+    return ((high_bit - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + sub_bucket;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t bucket) {
+    constexpr uint64_t sub_bucket_count = uint64_t{ 1 } << SUB_BUCKET_BITS;
+    if (bucket < sub_bucket_count) {
+        return bucket;
+    }
+    const size_t shift = (bucket >> SUB_BUCKET_BITS) - 1;
+    const uint64_t sub_bucket = bucket & (sub_bucket_count - 1);
+    return ((sub_bucket_count + sub_bucket + 1) << shift) - 1;
+}
+
+double LatencyHistogram::GetMeanNanoseconds() const {
+    return count_ == 0 ? 0.0 : static_cast<double>(total_nanoseconds_) / count_;
+}
+
+uint64_t LatencyHistogram::GetPercentileNanoseconds(double percentile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    // Ранг по ближайшему значению: не меньше 1 и не больше количества
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile * count_));
+    rank = std::max<uint64_t>(1, std::min(rank, count_));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += bucket_counts_[bucket];
+        if (seen >= rank) {
+            return GetBucketUpperBound(bucket);
+        }
+    }
+    return GetBucketUpperBound(BUCKET_COUNT - 1);
+}
+
+namespace {
+
+// Статистика одного потока. Пишет только поток-владелец, поэтому приращение -
+// отдельные relaxed-чтение и запись, а снимок из другого потока читает без гонок
+struct ThreadSearchStats {
+    std::array<std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT>, SEARCH_STAGE_COUNT> bucket_counts{};
+    std::array<std::atomic<uint64_t>, SEARCH_STAGE_COUNT> total_nanoseconds{};
+    std::array<std::atomic<uint64_t>, SEARCH_COUNTER_COUNT> counters{};
+};
+
+void Increase(std::atomic<uint64_t>& value, uint64_t delta) {
+    value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+// Прибавляет статистику потока from к to. Вызывается под блокировкой реестра
+void AddThreadStats(const ThreadSearchStats& from, ThreadSearchStats& to) {
+    for (size_t stage = 0; stage < SEARCH_STAGE_COUNT; ++stage) {
+        for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+            Increase(to.bucket_counts[stage][bucket], from.bucket_counts[stage][bucket].load(std::memory_order_relaxed));
+        }
+        Increase(to.total_nanoseconds[stage], from.total_nanoseconds[stage].load(std::memory_order_relaxed));
+    }
+    for (size_t counter = 0; counter < SEARCH_COUNTER_COUNT; ++counter) {
+        Increase(to.counters[counter], from.counters[counter].load(std::memory_order_relaxed));
+    }
+}
+
+// Статистика работающих потоков и сумма статистики завершенных
+struct SearchStatsRegistry {
+    std::mutex mutex;
+    std::vector<const ThreadSearchStats*> threads;
+    ThreadSearchStats retired;
+    // Состояние на момент последнего Reset
+    SearchStatsSnapshot baseline;
+};
+
+// Реестр не уничтожается: потоки статических пулов завершаются после уничтожения
+// статических объектов и при завершении переносят статистику в реестр
+SearchStatsRegistry& GetRegistry() {
+    static auto* registry = new SearchStatsRegistry;
+    return *registry;
+}
+
+// Статистика потока, зарегистрированная в реестре на время жизни потока.
+// При завершении потока она прибавляется к статистике завершенных потоков
+class ThreadStatsOwner {
+public:
+    ThreadStatsOwner() {
+        SearchStatsRegistry& registry = GetRegistry();
+        std::lock_guard guard(registry.mutex);
+        registry.threads.push_back(&stats_);
+    }
+
+    ThreadStatsOwner(const ThreadStatsOwner&) = delete;
+    ThreadStatsOwner& operator=(const ThreadStatsOwner&) = delete;
+
+    ~ThreadStatsOwner() {
+        SearchStatsRegistry& registry = GetRegistry();
+        std::lock_guard guard(registry.mutex);
+        AddThreadStats(stats_, registry.retired);
+        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), &stats_));
+    }
+
+    ThreadSearchStats& GetStats() {
+        return stats_;
+    }
+
+private:
+    ThreadSearchStats stats_;
+};
+
+ThreadSearchStats& GetThreadStats() {
+    thread_local ThreadStatsOwner owner;
+    return owner.GetStats();
+}
+
+} // namespace
+
+SearchStatsSnapshot SearchStats::SumThreadStats() {
+    const SearchStatsRegistry& registry = GetRegistry();
+    SearchStatsSnapshot snapshot;
+    std::vector<const ThreadSearchStats*> threads = registry.threads;
+    threads.push_back(&registry.retired);
+    for (const ThreadSearchStats* thread_stats : threads) {
+        for (size_t stage = 0; stage < SEARCH_STAGE_COUNT; ++stage) {
+            for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+                snapshot.stages[stage].bucket_counts_[bucket] +=
+                    thread_stats->bucket_counts[stage][bucket].load(std::memory_order_relaxed);
+            }
+            snapshot.stages[stage].total_nanoseconds_ +=
+                thread_stats->total_nanoseconds[stage].load(std::memory_order_relaxed);
+        }
+        for (size_t counter = 0; counter < SEARCH_COUNTER_COUNT; ++counter) {
+            snapshot.counters[counter] += thread_stats->counters[counter].load(std::memory_order_relaxed);
+        }
+    }
+    return snapshot;
+}
+
+void SearchStats::RecordImpl(SearchStage stage, uint64_t nanoseconds) {
+    ThreadSearchStats& stats = GetThreadStats();
+    const size_t index = static_cast<size_t>(stage);
+    Increase(stats.bucket_counts[index][LatencyHistogram::GetBucket(nanoseconds)], 1);
+    Increase(stats.total_nanoseconds[index], nanoseconds);
+}
+
+void SearchStats::AddImpl(SearchCounter counter, uint64_t value) {
+    Increase(GetThreadStats().counters[static_cast<size_t>(counter)], value);
+}
+
+SearchStatsSnapshot SearchStats::GetSnapshot() {
+    SearchStatsRegistry& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    SearchStatsSnapshot snapshot = SumThreadStats();
+    for (size_t stage = 0; stage < SEARCH_STAGE_COUNT; ++stage) {
+        LatencyHistogram& histogram = snapshot.stages[stage];
+        const LatencyHistogram& baseline = registry.baseline.stages[stage];
+        for (size_t bucket = 0; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket) {
+            histogram.bucket_counts_[bucket] -= baseline.bucket_counts_[bucket];
+            histogram.count_ += histogram.bucket_counts_[bucket];
+        }
+        histogram.total_nanoseconds_ -= baseline.total_nanoseconds_;
+    }
+    for (size_t counter = 0; counter < SEARCH_COUNTER_COUNT; ++counter) {
+        snapshot.counters[counter] -= registry.baseline.counters[counter];
+    }
+    return snapshot;
+}
+
+void SearchStats::Reset() {
+    SearchStatsRegistry& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    registry.baseline = SumThreadStats();
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Этапы обработки, время которых замеряется:
+// TOKENIZE - разбиение текста документа на слова при добавлении;
+// PARSE_QUERY - разбор запроса;
+// MINUS_FILTER - подготовка курсоров по спискам минус-слов;
+// POSTINGS - обход списков документов плюс-слов с накоплением релевантности.
+// В MaxScore обход, расчет релевантности, проверка минус-слов и отбор - один цикл,
+// его время целиком относится к POSTINGS;
+// SCORING - сбор найденных документов с итоговой релевантностью при полном переборе;
+// RANKING - отбор лучших документов из найденных и объединение частичных результатов
+enum class SearchStage {
+    TOKENIZE,
+    PARSE_QUERY,
+    MINUS_FILTER,
+    POSTINGS,
+    SCORING,
+    RANKING,
+};
+
+const size_t SEARCH_STAGE_COUNT = 6;
+
+// Счетчики:
+// QUERIES - выполненные поиски лучших документов;
+// POSTINGS_SCANNED - пройденные позиции списков документов плюс-слов;
+// DOCUMENTS_SCORED - документы, для которых посчитана итоговая релевантность;
+// DOCUMENTS_EXCLUDED - документы, отброшенные из-за минус-слов;
+// CACHE_HITS, CACHE_MISSES - обращения к кешу результатов
+enum class SearchCounter {
+    QUERIES,
+    POSTINGS_SCANNED,
+    DOCUMENTS_SCORED,
+    DOCUMENTS_EXCLUDED,
+    CACHE_HITS,
+    CACHE_MISSES,
+};
+
+const size_t SEARCH_COUNTER_COUNT = 6;
+
+std::string_view GetSearchStageName(SearchStage stage);
+
+std::string_view GetSearchCounterName(SearchCounter counter);
+
+// Гистограмма длительностей в наносекундах: каждый интервал [2^k, 2^(k+1)) делится
+// на 8 равных корзин, поэтому перцентиль определяется с точностью до 12.5%
+class LatencyHistogram {
+public:
+    static constexpr size_t SUB_BUCKET_BITS = 3;
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    static size_t GetBucket(uint64_t nanoseconds);
+
+    // Наибольшая длительность, попадающая в корзину
+    static uint64_t GetBucketUpperBound(size_t bucket);
+
+    uint64_t GetCount() const {
+        return count_;
+    }
+
+    uint64_t GetTotalNanoseconds() const {
+        return total_nanoseconds_;
+    }
+
+    double GetMeanNanoseconds() const;
+
+    // Верхняя граница корзины, в которую попадает доля percentile длительностей (от 0 до 1)
+    uint64_t GetPercentileNanoseconds(double percentile) const;
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> bucket_counts_{};
+    uint64_t count_ = 0;
+    uint64_t total_nanoseconds_ = 0;
+
+    friend class SearchStats;
+};
+
+// Статистика с момента последнего SearchStats::Reset
+struct SearchStatsSnapshot {
+    std::array<LatencyHistogram, SEARCH_STAGE_COUNT> stages;
+    std::array<uint64_t, SEARCH_COUNTER_COUNT> counters{};
+
+    const LatencyHistogram& GetStage(SearchStage stage) const {
+        return stages[static_cast<size_t>(stage)];
+    }
+
+    uint64_t GetCounter(SearchCounter counter) const {
+        return counters[static_cast<size_t>(counter)];
+    }
+};
+
+// Статистика этапов и счетчики всех серверов процесса. Собирается только при сборке
+// с SEARCH_SERVER_STATS, иначе замеры и счетчики не компилируются, а снимок пуст.
+// Каждый поток пишет в собственные гистограммы без блокировок и атомарных
+// read-modify-write операций; снимок суммирует данные всех потоков, в том числе завершенных
+class SearchStats {
+public:
+#ifdef SEARCH_SERVER_STATS
+    static constexpr bool IS_ENABLED = true;
+#else
+    static constexpr bool IS_ENABLED = false;
+#endif
+
+    static void Record([[maybe_unused]] SearchStage stage, [[maybe_unused]] uint64_t nanoseconds) {
+#ifdef SEARCH_SERVER_STATS
+        RecordImpl(stage, nanoseconds);
+#endif
+    }
+
+    static void Add([[maybe_unused]] SearchCounter counter, [[maybe_unused]] uint64_t value = 1) {
+#ifdef SEARCH_SERVER_STATS
+        AddImpl(counter, value);
+#endif
+    }
+
+    static SearchStatsSnapshot GetSnapshot();
+
+    // Обнуляет статистику: последующие снимки считаются от текущего состояния
+    static void Reset();
+
+private:
+    static void RecordImpl(SearchStage stage, uint64_t nanoseconds);
+    static void AddImpl(SearchCounter counter, uint64_t value);
+
+    // Сумма статистики всех потоков; вызывается под блокировкой реестра потоков
+    static SearchStatsSnapshot SumThreadStats();
+};
+
+// Замеряет время этапа от создания до уничтожения
+class SearchStageTimer {
+public:
+#ifdef SEARCH_SERVER_STATS
+    explicit SearchStageTimer(SearchStage stage)
+        : stage_(stage) {
+    }
+
+    ~SearchStageTimer() {
+        const auto duration = std::chrono::steady_clock::now() - start_time_;
+        SearchStats::Record(stage_,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+private:
+    SearchStage stage_;
+    std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+#else
+    explicit SearchStageTimer(SearchStage) {
+    }
+#endif
+
+public:
+    SearchStageTimer(const SearchStageTimer&) = delete;
+    SearchStageTimer& operator=(const SearchStageTimer&) = delete;
+};
+
+// Счетчик для циклов: значение копится в локальной переменной
+// и добавляется в статистику потока при уничтожении
+class LocalSearchCounter {
+public:
+#ifdef SEARCH_SERVER_STATS
+    explicit LocalSearchCounter(SearchCounter counter)
+        : counter_(counter) {
+    }
+
+    ~LocalSearchCounter() {
+        SearchStats::Add(counter_, value_);
+    }
+
+    void Add(uint64_t value = 1) {
+        value_ += value;
+    }
+
+private:
+    SearchCounter counter_;
+    uint64_t value_ = 0;
+#else
+    explicit LocalSearchCounter(SearchCounter) {
+    }
+
+    void Add(uint64_t = 1) {
+    }
+#endif
+
+public:
+    LocalSearchCounter(const LocalSearchCounter&) = delete;
+    LocalSearchCounter& operator=(const LocalSearchCounter&) = delete;
+};
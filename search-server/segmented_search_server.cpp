@@ -0,0 +1,299 @@
+#include "segmented_search_server.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+using namespace std::string_literals;
+
+SegmentedSearchServer::SegmentedSearchServer(std::string_view stop_words_text, const SegmentOptions& options)
+    : SegmentedSearchServer(SplitIntoWordsView(stop_words_text), options) {
+}
+
+SegmentedSearchServer::~SegmentedSearchServer() {
+    {
+        std::unique_lock lock(mutex_);
+        stopping_ = true;
+    }
+    merge_condition_.notify_all();
+    if (merge_thread_.joinable()) {
+        merge_thread_.join();
+    }
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings) {
+    if (document_id < 0) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+    // Разбор текста не требует блокировки
+    thread_local std::vector<std::string_view> words;
+    thread_local TextAnalyzer::WordFreqs word_freqs;
+    text_analyzer_.ComputeWordFreqs(document, words, word_freqs);
+    const int rating = SearchServer::ComputeAverageRating(ratings);
+
+    {
+        std::unique_lock lock(mutex_);
+        if (document_locations_.count(document_id) > 0) {
+            throw std::invalid_argument("Invalid document_id. ID already exists"s);
+        }
+        Segment& buffer = *buffer_.segment;
+        const int ordinal = static_cast<int>(buffer.GetDocumentCount());
+        buffer.AddDocument(document_id, rating, status, word_freqs);
+        buffer_.deleted.push_back(false);
+        document_locations_.emplace(document_id, DocumentLocation{ &buffer, ordinal });
+        for (const auto& [word, _] : word_freqs) {
+            AddWordDocumentCount(word);
+        }
+        if (buffer.GetDocumentCount() < options_.buffer_document_count) {
+            return;
+        }
+        SealBuffer();
+    }
+    if (options_.background_merge) {
+        merge_condition_.notify_all();
+    }
+    else {
+        while (MergeOnce()) {
+        }
+    }
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id) {
+    {
+        std::unique_lock lock(mutex_);
+        const auto location = document_locations_.find(document_id);
+        if (location == document_locations_.end()) {
+            throw std::invalid_argument("Invalid ID. ID is doesn't exist"s);
+        }
+        const auto [segment, ordinal] = location->second;
+        document_locations_.erase(location);
+
+        // Документ остается в сегменте до слияния, отмечается только удаление
+        SegmentState& state = *FindSegmentState(segment);
+        state.deleted[ordinal] = true;
+        ++state.deleted_count;
+        for (size_t i = segment->word_offsets[ordinal]; i < segment->word_offsets[ordinal + 1]; ++i) {
+            RemoveWordDocumentCount(segment->words[i]);
+        }
+    }
+    if (options_.background_merge) {
+        merge_condition_.notify_all();
+    }
+    else {
+        while (MergeOnce()) {
+        }
+    }
+}
+
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+    size_t top_count) const {
+    return FindTopDocuments(raw_query,
+        [status](int, DocumentStatus document_status, int) {
+            return document_status == status;
+        },
+        top_count);
+}
+
+SearchServer::MyTuple SegmentedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    Query& query = TextAnalyzer::GetThreadQuery();
+    text_analyzer_.ParseQuery(raw_query, query);
+
+    std::shared_lock lock(mutex_);
+    const auto location = document_locations_.find(document_id);
+    if (location == document_locations_.end()) {
+        throw std::out_of_range("Invalid document id. Document id is doesn't exist"s);
+    }
+    const auto [segment, ordinal] = location->second;
+    return MatchSegmentDocument(*segment, ordinal, query);
+}
+
+int SegmentedSearchServer::GetDocumentCount() const {
+    std::shared_lock lock(mutex_);
+    return static_cast<int>(document_locations_.size());
+}
+
+void SegmentedSearchServer::Flush() {
+    {
+        std::unique_lock lock(mutex_);
+        if (buffer_.segment->GetDocumentCount() == 0) {
+            return;
+        }
+        SealBuffer();
+    }
+    if (options_.background_merge) {
+        merge_condition_.notify_all();
+    }
+    else {
+        while (MergeOnce()) {
+        }
+    }
+}
+
+void SegmentedSearchServer::WaitForMerges() {
+    std::unique_lock lock(mutex_);
+    merge_condition_.wait(lock, [this] {
+        const auto [first, last] = FindSegmentMergeRange(segments_, options_.merge_factor);
+        return !merging_ && first == last;
+    });
+}
+
+SegmentedSearchServer::SegmentStats SegmentedSearchServer::GetSegmentStats() const {
+    std::shared_lock lock(mutex_);
+    SegmentStats stats{ segments_.size(), buffer_.segment->GetDocumentCount(), buffer_.deleted_count, merge_count_ };
+    for (const SegmentState& state : segments_) {
+        stats.tombstone_count += state.deleted_count;
+    }
+    return stats;
+}
+
+void SegmentedSearchServer::StartMerging() {
+    buffer_.segment = std::make_shared<Segment>();
+    if (options_.merge_factor < 2) {
+        throw std::invalid_argument("Merge factor must be at least 2"s);
+    }
+    if (options_.background_merge) {
+        merge_thread_ = std::thread([this] {
+            RunMergeLoop();
+        });
+    }
+}
+
+bool SegmentedSearchServer::MergeOnce() {
+    // Выбираем сегменты и копируем отметки удалений под блокировкой
+    std::vector<SegmentState> sources;
+    {
+        std::unique_lock lock(mutex_);
+        if (merging_) {
+            return false;
+        }
+        const auto [first, last] = FindSegmentMergeRange(segments_, options_.merge_factor);
+        if (first == last) {
+            return false;
+        }
+        sources.assign(segments_.begin() + first, segments_.begin() + last);
+        merging_ = true;
+    }
+
+    // Сегменты неизменяемы, поэтому новый сегмент строится без блокировки
+    std::vector<const Segment*> source_segments;
+    std::vector<const std::vector<bool>*> source_deleted;
+    size_t level = 0;
+    for (const SegmentState& source : sources) {
+        source_segments.push_back(source.segment.get());
+        source_deleted.push_back(&source.deleted);
+        level = std::max(level, source.level);
+    }
+    auto [merged, new_ordinals] = MergeIndexSegments(source_segments, source_deleted);
+
+    {
+        std::unique_lock lock(mutex_);
+        // Сегменты сливает только этот поток, поэтому диапазон остался на месте,
+        // а после слияния могли появиться лишь новые сегменты в конце
+        const auto first = std::find_if(segments_.begin(), segments_.end(),
+            [&sources](const SegmentState& state) {
+                return state.segment == sources.front().segment;
+            });
+        SegmentState merged_state{ merged, std::vector<bool>(merged->GetDocumentCount(), false), 0,
+            sources.size() > 1 ? level + 1 : level };
+
+        // Переносим удаления, сделанные во время слияния
+        for (size_t s = 0; s < sources.size(); ++s) {
+            const SegmentState& current = *(first + s);
+            for (size_t ordinal = 0; ordinal < new_ordinals[s].size(); ++ordinal) {
+                const int merged_ordinal = new_ordinals[s][ordinal];
+                if (merged_ordinal != -1 && current.deleted[ordinal]) {
+                    merged_state.deleted[merged_ordinal] = true;
+                    ++merged_state.deleted_count;
+                }
+            }
+        }
+        for (size_t ordinal = 0; ordinal < merged->GetDocumentCount(); ++ordinal) {
+            if (!merged_state.deleted[ordinal]) {
+                document_locations_[merged->document_ids[ordinal]] = { merged.get(), static_cast<int>(ordinal) };
+            }
+        }
+        const auto last = segments_.erase(first, first + sources.size());
+        if (merged->GetDocumentCount() > 0) {
+            segments_.insert(last, std::move(merged_state));
+        }
+        merging_ = false;
+        ++merge_count_;
+    }
+    merge_condition_.notify_all();
+    return true;
+}
+
+void SegmentedSearchServer::RunMergeLoop() {
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            merge_condition_.wait(lock, [this] {
+                const auto [first, last] = FindSegmentMergeRange(segments_, options_.merge_factor);
+                return stopping_ || first != last;
+            });
+            if (stopping_) {
+                return;
+            }
+        }
+        while (MergeOnce()) {
+        }
+    }
+}
+
+void SegmentedSearchServer::SealBuffer() {
+    segments_.push_back(std::move(buffer_));
+    buffer_ = SegmentState{ std::make_shared<Segment>(), {} };
+}
+
+SegmentedSearchServer::SegmentState* SegmentedSearchServer::FindSegmentState(const Segment* segment) {
+    if (buffer_.segment.get() == segment) {
+        return &buffer_;
+    }
+    for (SegmentState& state : segments_) {
+        if (state.segment.get() == segment) {
+            return &state;
+        }
+    }
+    return nullptr;
+}
+
+void SegmentedSearchServer::AddWordDocumentCount(std::string_view word) {
+    auto* entry = word_document_counts_.FindEntry(word);
+    if (entry == nullptr) {
+        entry = &word_document_counts_.Insert(words_.Store(word), 0);
+    }
+    ++entry->value;
+}
+
+void SegmentedSearchServer::RemoveWordDocumentCount(std::string_view word) {
+    auto* entry = word_document_counts_.FindEntry(word);
+    if (--entry->value > 0) {
+        return;
+    }
+    const std::string_view stored_word = entry->key;
+    word_document_counts_.Erase(stored_word);
+    words_.Release(stored_word);
+
+    // Слова удаленных документов копятся в арене, пока их не станет больше живых
+    const ArenaStats stats = words_.GetStats();
+    if (stats.dead_bytes >= COMPACTION_MIN_DEAD_BYTES && stats.dead_bytes > stats.live_bytes) {
+        TermArena words;
+        StringHashMap<int> word_document_counts;
+        word_document_counts.Reserve(word_document_counts_.size());
+        for (const auto& [stored, count] : word_document_counts_) {
+            word_document_counts.Insert(words.Store(stored), count);
+        }
+        word_document_counts_ = std::move(word_document_counts);
+        words_ = std::move(words);
+    }
+}
+
+double SegmentedSearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
+    const auto* entry = word_document_counts_.FindEntry(word);
+    if (entry == nullptr) {
+        return 0.0;
+    }
+    return std::log(document_locations_.size()) - std::log(entry->value);
+}
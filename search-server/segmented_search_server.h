@@ -0,0 +1,179 @@
+#pragma once
+#include "document.h"
+#include "index_segment.h"
+#include "search_server.h"
+#include "string_hash_map.h"
+#include "term_arena.h"
+#include "text_analyzer.h"
+#include "top_documents.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Параметры сегментированного индекса:
+// buffer_document_count - количество документов в буфере записи, после которого
+// буфер становится неизменяемым сегментом;
+// merge_factor - количество соседних сегментов одного уровня, которые сливаются в один;
+// background_merge - сливать сегменты в фоновом потоке, иначе в потоке писателя
+struct SegmentOptions {
+    size_t buffer_document_count = 1024;
+    size_t merge_factor = 4;
+    bool background_merge = true;
+};
+
+// Поисковый сервер с индексом из неизменяемых сегментов (LSM).
+// Новые документы попадают в небольшой буфер записи, заполненный буфер становится
+// сегментом. Удаление только отмечает документ в битовой карте сегмента, память
+// освобождается при слиянии. Фоновый поток сливает по merge_factor соседних сегментов
+// одного уровня в сегмент следующего уровня, отбрасывая удаленные документы.
+// Поиск обходит все сегменты; IDF считается по общим для сервера частотам слов,
+// поэтому релевантность совпадает с SearchServer, содержащим те же документы.
+// Методы можно вызывать из разных потоков: поиск выполняется под разделяемой
+// блокировкой, изменения - под исключительной
+class SegmentedSearchServer {
+public:
+    template <typename StringContainer>
+    explicit SegmentedSearchServer(const StringContainer& stop_words, const SegmentOptions& options = {});
+
+    explicit SegmentedSearchServer(std::string_view stop_words_text, const SegmentOptions& options = {});
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    // Останавливает фоновое слияние
+    ~SegmentedSearchServer();
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    SearchServer::MyTuple MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+
+    // Превращает непустой буфер записи в сегмент
+    void Flush();
+
+    // Ждет, пока фоновый поток не сольет все сегменты, требующие слияния
+    void WaitForMerges();
+
+    // Состояние индекса:
+    // segment_count - количество неизменяемых сегментов;
+    // buffered_document_count - документов в буфере записи;
+    // tombstone_count - удаленных документов, еще занимающих место в сегментах;
+    // merge_count - выполненных слияний
+    struct SegmentStats {
+        size_t segment_count;
+        size_t buffered_document_count;
+        size_t tombstone_count;
+        size_t merge_count;
+    };
+
+    SegmentStats GetSegmentStats() const;
+
+private:
+    using Segment = IndexSegment;
+
+    // Сегмент в списке сегментов сервера:
+    // deleted - отметки удаленных документов по порядковым номерам;
+    // level - уровень слияния: 0 у сегмента из буфера записи, слияние повышает уровень
+    struct SegmentState {
+        std::shared_ptr<Segment> segment;
+        std::vector<bool> deleted;
+        size_t deleted_count = 0;
+        size_t level = 0;
+    };
+
+    // Расположение документа: сегмент и порядковый номер в нем
+    struct DocumentLocation {
+        const Segment* segment;
+        int ordinal;
+    };
+
+    using Query = TextAnalyzer::Query;
+
+    TextAnalyzer text_analyzer_;
+    SegmentOptions options_;
+
+    mutable std::shared_mutex mutex_;
+
+    // Неизменяемые сегменты от старых к новым, затем буфер записи
+    std::vector<SegmentState> segments_;
+    SegmentState buffer_;
+
+    std::unordered_map<int, DocumentLocation> document_locations_;
+
+    // Количество неудаленных документов с каждым словом по всем сегментам
+    StringHashMap<int> word_document_counts_;
+    TermArena words_;
+
+    std::condition_variable_any merge_condition_;
+    bool merging_ = false;
+    bool stopping_ = false;
+    size_t merge_count_ = 0;
+    std::thread merge_thread_;
+
+    void StartMerging();
+
+    // Сливает один диапазон сегментов. Возвращает false, если сливать нечего
+    bool MergeOnce();
+
+    void RunMergeLoop();
+
+    // Делает буфер записи сегментом. Вызывается под исключительной блокировкой
+    void SealBuffer();
+
+    SegmentState* FindSegmentState(const Segment* segment);
+
+    void AddWordDocumentCount(std::string_view word);
+
+    void RemoveWordDocumentCount(std::string_view word);
+
+    // IDF слова по неудаленным документам всех сегментов, 0 для отсутствующих слов
+    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+};
+
+template <typename StringContainer>
+SegmentedSearchServer::SegmentedSearchServer(const StringContainer& stop_words, const SegmentOptions& options)
+    : text_analyzer_(stop_words)
+    , options_(options) {
+    StartMerging();
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query,
+    DocumentPredicate document_predicate, size_t top_count) const {
+    Query& query = TextAnalyzer::GetThreadQuery();
+    text_analyzer_.ParseQuery(raw_query, query);
+
+    std::shared_lock lock(mutex_);
+    std::vector<double> inverse_document_freqs(query.plus_words.size());
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        inverse_document_freqs[i] = ComputeWordInverseDocumentFreq(query.plus_words[i]);
+    }
+
+    // Документы всех сегментов отбираются в общий набор лучших документов
+    TopDocuments top_documents(top_count);
+    for (const SegmentState& state : segments_) {
+        AddSegmentDocuments(*state.segment, state.deleted, query, inverse_document_freqs, document_predicate,
+            top_documents);
+    }
+    AddSegmentDocuments(*buffer_.segment, buffer_.deleted, query, inverse_document_freqs, document_predicate,
+        top_documents);
+    return top_documents.Build();
+}
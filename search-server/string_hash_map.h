@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Хеш-таблица с открытой адресацией и линейным пробированием для ключей string_view.
+// Таблица не владеет строками ключей: они должны жить дольше таблицы.
+// Хеши ключей хранятся в отдельном плотном массиве, поэтому поиск просматривает
+// соседние 8-байтные ячейки и сравнивает строки только при совпадении хеша.
+// Вставка может перераспределить память и сделать недействительными указатели на элементы
+template <typename Value>
+class StringHashMap {
+public:
+    struct Entry {
+        std::string_view key;
+        Value value;
+    };
+
+    template <bool IsConst>
+    class BasicIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const Entry*, Entry*>;
+        using reference = std::conditional_t<IsConst, const Entry&, Entry&>;
+        using Map = std::conditional_t<IsConst, const StringHashMap, StringHashMap>;
+
+        BasicIterator(Map* map, size_t slot)
+            : map_(map)
+            , slot_(slot) {
+            SkipEmpty();
+        }
+
+        reference operator*() const {
+            return map_->entries_[slot_];
+        }
+
+        pointer operator->() const {
+            return &map_->entries_[slot_];
+        }
+
+        BasicIterator& operator++() {
+            ++slot_;
+            SkipEmpty();
+            return *this;
+        }
+
+        bool operator==(const BasicIterator& other) const {
+            return slot_ == other.slot_;
+        }
+
+        bool operator!=(const BasicIterator& other) const {
+            return slot_ != other.slot_;
+        }
+
+    private:
+        void SkipEmpty() {
+            while (slot_ < map_->hashes_.size() && map_->hashes_[slot_] == EMPTY_SLOT) {
+                ++slot_;
+            }
+        }
+
+        Map* map_;
+        size_t slot_;
+    };
+
+    using iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true>;
+
+    // Возвращает элемент с ключом key или nullptr
+    Entry* FindEntry(std::string_view key) {
+        const size_t slot = FindSlot(key, HashKey(key));
+        return hashes_.empty() || hashes_[slot] == EMPTY_SLOT ? nullptr : &entries_[slot];
+    }
+
+    const Entry* FindEntry(std::string_view key) const {
+        return const_cast<StringHashMap*>(this)->FindEntry(key);
+    }
+
+    // Вставляет элемент с ключом, которого еще нет в таблице
+    Entry& Insert(std::string_view key, Value value) {
+        if ((size_ + 1) * MAX_LOAD_DENOMINATOR > hashes_.size() * MAX_LOAD_NUMERATOR) {
+            Rehash(std::max<size_t>(MIN_CAPACITY, hashes_.size() * 2));
+        }
+        const uint64_t hash = HashKey(key);
+        const size_t slot = FindSlot(key, hash);
+        hashes_[slot] = hash;
+        entries_[slot] = Entry{ key, std::move(value) };
+        ++size_;
+        return entries_[slot];
+    }
+
+    // Удаляет элемент, сдвигая назад следующие за ним элементы той же цепочки.
+    // Возвращает false, если ключа нет в таблице
+    bool Erase(std::string_view key) {
+        if (hashes_.empty()) {
+            return false;
+        }
+        size_t hole = FindSlot(key, HashKey(key));
+        if (hashes_[hole] == EMPTY_SLOT) {
+            return false;
+        }
+        const size_t mask = hashes_.size() - 1;
+        for (size_t slot = (hole + 1) & mask; hashes_[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+            const size_t home = hashes_[slot] & mask;
+            // Элемент остается на месте, если его домашняя ячейка лежит между дыркой и им
+            const bool stays = hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot);
+            if (!stays) {
+                hashes_[hole] = hashes_[slot];
+                entries_[hole] = std::move(entries_[slot]);
+                hole = slot;
+            }
+        }
+        hashes_[hole] = EMPTY_SLOT;
+        entries_[hole] = Entry{};
+        --size_;
+        return true;
+    }
+
+    void Reserve(size_t size) {
+        size_t capacity = MIN_CAPACITY;
+        while (size * MAX_LOAD_DENOMINATOR > capacity * MAX_LOAD_NUMERATOR) {
+            capacity *= 2;
+        }
+        if (capacity > hashes_.size()) {
+            Rehash(capacity);
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    iterator begin() {
+        return { this, 0 };
+    }
+
+    iterator end() {
+        return { this, hashes_.size() };
+    }
+
+    const_iterator begin() const {
+        return { this, 0 };
+    }
+
+    const_iterator end() const {
+        return { this, hashes_.size() };
+    }
+
+    // Память ячеек таблицы в байтах (без памяти, на которую ссылаются значения)
+    size_t GetMemoryUsage() const {
+        return hashes_.capacity() * sizeof(uint64_t) + entries_.capacity() * sizeof(Entry);
+    }
+
+private:
+    static constexpr uint64_t EMPTY_SLOT = 0;
+    static constexpr size_t MIN_CAPACITY = 16;
+    static constexpr size_t MAX_LOAD_NUMERATOR = 7;
+    static constexpr size_t MAX_LOAD_DENOMINATOR = 10;
+
+    // Старший бит отличает занятую ячейку от пустой, младшие биты задают домашнюю ячейку
+    static uint64_t HashKey(std::string_view key) {
+        return static_cast<uint64_t>(std::hash<std::string_view>{}(key)) | (uint64_t{ 1 } << 63);
+    }
+
+    // Ячейка с ключом key или первая пустая ячейка его цепочки
+    size_t FindSlot(std::string_view key, uint64_t hash) const {
+        if (hashes_.empty()) {
+            return 0;
+        }
+        const size_t mask = hashes_.size() - 1;
+        size_t slot = hash & mask;
+        while (hashes_[slot] != EMPTY_SLOT
+            && (hashes_[slot] != hash || entries_[slot].key != key)) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void Rehash(size_t capacity) {
+        std::vector<uint64_t> hashes(capacity, EMPTY_SLOT);
+        std::vector<Entry> entries(capacity);
+        std::swap(hashes, hashes_);
+        std::swap(entries, entries_);
+        const size_t mask = capacity - 1;
+        for (size_t i = 0; i < hashes.size(); ++i) {
+            if (hashes[i] != EMPTY_SLOT) {
+                size_t slot = hashes[i] & mask;
+                while (hashes_[slot] != EMPTY_SLOT) {
+                    slot = (slot + 1) & mask;
+                }
+                hashes_[slot] = hashes[i];
+                entries_[slot] = std::move(entries[i]);
+            }
+        }
+    }
+
+    std::vector<uint64_t> hashes_;
+    std::vector<Entry> entries_;
+    size_t size_ = 0;
+};
+
+// Множество строк на основе StringHashMap. Как и таблица, не владеет строками
+class StringHashSet {
+public:
+    // Возвращает false, если строка уже есть в множестве
+    bool Insert(std::string_view key) {
+        if (map_.FindEntry(key) != nullptr) {
+            return false;
+        }
+        map_.Insert(key, {});
+        return true;
+    }
+
+    bool Contains(std::string_view key) const {
+        return map_.FindEntry(key) != nullptr;
+    }
+
+    size_t size() const {
+        return map_.size();
+    }
+
+    auto begin() const {
+        return map_.begin();
+    }
+
+    auto end() const {
+        return map_.end();
+    }
+
+private:
+    struct Empty {
+    };
+
+    StringHashMap<Empty> map_;
+};
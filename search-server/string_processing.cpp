@@ -1,5 +1,9 @@
 #include "string_processing.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 std::vector<std::string> SplitIntoWords(const std::string& text) {
     std::vector<std::string> words;
     std::string word;
@@ -22,30 +26,52 @@ std::vector<std::string> SplitIntoWords(const std::string& text) {
 
 std::vector<std::string_view> SplitIntoWordsView(std::string_view str) {
     std::vector<std::string_view> result;
-    // Удаляем начало до первого непробельного символа
-    str.remove_prefix(std::min(str.size(), str.find_first_not_of(" ")));
+    ForEachWord(str, [&result](std::string_view word, bool) {
+        result.push_back(word);
+    });
+    return result;
+}
+
+namespace {
 
-    while (!str.empty()) {
-        std::string_view str_to_result;
-        // Определение первого пробельного символа
-        auto space = str.find(' ');
+bool IsControlChar(char c) {
+    return c >= '\0' && c < ' ';
+}
 
-        if (space == str.npos) {
-            result.push_back(str);
-            break;
+// Позиция первого спецсимвола (и пробела, если with_space) начиная с pos
+size_t FindSpecialChar(std::string_view text, size_t pos, bool with_space) {
+#ifdef __SSE2__
+    const __m128i max_control = _mm_set1_epi8(' ' - 1);
+    const __m128i space = _mm_set1_epi8(' ');
+    for (; pos + 16 <= text.size(); pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + pos));
+        // Беззнаковое сравнение chunk <= 31: min(chunk, 31) == chunk
+        __m128i special = _mm_cmpeq_epi8(_mm_min_epu8(chunk, max_control), chunk);
+        if (with_space) {
+            special = _mm_or_si128(special, _mm_cmpeq_epi8(chunk, space));
         }
-        else {
-            // Определение слова
-            str_to_result = str.substr(0, space);
+        const int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
         }
-        // Определяем позицию первого непробельного символа после найденного первого пробела
-        auto new_word = str.find_first_not_of(" ", space);
-        // Удаляем начало строки до нового непробельного символа
-        str.remove_prefix(std::min(str.size(), new_word));
-
-        result.push_back(str_to_result);
     }
-    return result;
+#endif
+    for (; pos < text.size(); ++pos) {
+        if (IsControlChar(text[pos]) || (with_space && text[pos] == ' ')) {
+            return pos;
+        }
+    }
+    return text.size();
+}
+
+}  // namespace
+
+size_t FindSpaceOrControlChar(std::string_view text, size_t pos) {
+    return FindSpecialChar(text, pos, true);
+}
+
+bool HasNoControlChars(std::string_view text) {
+    return FindSpecialChar(text, 0, false) == text.size();
 }
 
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(std::string_view text) {
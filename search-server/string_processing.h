@@ -1,9 +1,39 @@
 #pragma once
+#include <cstddef>
 #include <set>
 #include <string>
 #include <string_view>
 #include <vector>
 
+// Возвращает позицию первого пробела или спецсимвола (коды 0-31) в text, начиная с pos,
+// или text.size(), если таких символов нет. Просматривает строку блоками по 16 байт
+size_t FindSpaceOrControlChar(std::string_view text, size_t pos);
+
+// Возвращает true, если строка не содержит спецсимволов (коды 0-31)
+bool HasNoControlChars(std::string_view text);
+
+// Вызывает callback(word, is_valid) для каждого слова строки text, не выделяя память.
+// Слова разделены пробелами; is_valid == false, если слово содержит спецсимволы
+template <typename Callback>
+void ForEachWord(std::string_view text, Callback callback) {
+    size_t pos = 0;
+    while (true) {
+        pos = text.find_first_not_of(' ', pos);
+        if (pos == text.npos) {
+            return;
+        }
+        const size_t word_begin = pos;
+        bool is_valid = true;
+        pos = FindSpaceOrControlChar(text, pos);
+        // Спецсимволы не разделяют слова, а делают их некорректными
+        while (pos < text.size() && text[pos] != ' ') {
+            is_valid = false;
+            pos = FindSpaceOrControlChar(text, pos + 1);
+        }
+        callback(text.substr(word_begin, pos - word_begin), is_valid);
+    }
+}
+
 std::vector<std::string_view> SplitIntoWordsView(std::string_view text);
 
 std::vector<std::string> SplitIntoWords(const std::string& text);
@@ -0,0 +1,75 @@
+#include "term_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+TermArena::TermArena(const TermArena& other)
+    : blocks_(other.blocks_)
+    , stats_(other.stats_) {
+    // Свободное место последнего блока остается за оригиналом
+}
+
+TermArena& TermArena::operator=(const TermArena& other) {
+    if (this != &other) {
+        blocks_ = other.blocks_;
+        block_data_ = nullptr;
+        block_used_ = 0;
+        block_capacity_ = 0;
+        stats_ = other.stats_;
+    }
+    return *this;
+}
+
+TermArena::TermArena(TermArena&& other) noexcept
+    : blocks_(std::move(other.blocks_))
+    , block_data_(std::exchange(other.block_data_, nullptr))
+    , block_used_(std::exchange(other.block_used_, 0))
+    , block_capacity_(std::exchange(other.block_capacity_, 0))
+    , stats_(std::exchange(other.stats_, {})) {
+}
+
+TermArena& TermArena::operator=(TermArena&& other) noexcept {
+    if (this != &other) {
+        blocks_ = std::move(other.blocks_);
+        block_data_ = std::exchange(other.block_data_, nullptr);
+        block_used_ = std::exchange(other.block_used_, 0);
+        block_capacity_ = std::exchange(other.block_capacity_, 0);
+        stats_ = std::exchange(other.stats_, {});
+    }
+    return *this;
+}
+
+std::string_view TermArena::Store(std::string_view word) {
+    if (word.empty()) {
+        return {};
+    }
+    if (block_capacity_ - block_used_ < word.size()) {
+        // Слова длиннее блока получают отдельный блок
+        block_capacity_ = std::max(BLOCK_SIZE, word.size());
+        block_data_ = new char[block_capacity_];
+        blocks_.emplace_back(block_data_);
+        block_used_ = 0;
+        stats_.reserved_bytes += block_capacity_;
+    }
+    char* data = block_data_ + block_used_;
+    std::memcpy(data, word.data(), word.size());
+    block_used_ += word.size();
+    stats_.live_bytes += word.size();
+    return { data, word.size() };
+}
+
+void TermArena::Adopt(std::shared_ptr<const char[]> block, size_t word_bytes) {
+    blocks_.push_back(std::move(block));
+    stats_.live_bytes += word_bytes;
+    stats_.reserved_bytes += word_bytes;
+}
+
+void TermArena::Release(std::string_view word) {
+    stats_.live_bytes -= word.size();
+    stats_.dead_bytes += word.size();
+}
+
+ArenaStats TermArena::GetStats() const {
+    return stats_;
+}
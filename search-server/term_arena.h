@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Статистика арены слов:
+// live_bytes - байты слов, на которые есть ссылки в индексе;
+// dead_bytes - байты освобожденных слов, возвращаются только при уплотнении;
+// reserved_bytes - суммарный размер выделенных блоков
+struct ArenaStats {
+    size_t live_bytes = 0;
+    size_t dead_bytes = 0;
+    size_t reserved_bytes = 0;
+};
+
+// Хранилище слов индекса: каждое слово копируется в блок арены один раз,
+// ссылки string_view на него остаются действительными, пока жива арена.
+// Блоки не изменяются после записи слов, поэтому копия арены разделяет их
+// с оригиналом и записывает новые слова в собственные блоки
+class TermArena {
+public:
+    TermArena() = default;
+
+    TermArena(const TermArena& other);
+    TermArena& operator=(const TermArena& other);
+
+    TermArena(TermArena&& other) noexcept;
+    TermArena& operator=(TermArena&& other) noexcept;
+
+    // Копирует слово в арену и возвращает ссылку на копию
+    std::string_view Store(std::string_view word);
+
+    // Принимает блок с уже записанными словами суммарной длиной word_bytes,
+    // например область отображенного в память файла. Блок не изменяется
+    void Adopt(std::shared_ptr<const char[]> block, size_t word_bytes);
+
+    // Отмечает слово как неиспользуемое
+    void Release(std::string_view word);
+
+    ArenaStats GetStats() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::shared_ptr<const char[]>> blocks_;
+    // Последний блок, принадлежащий только этой арене и доступный для записи
+    char* block_data_ = nullptr;
+    size_t block_used_ = 0;
+    size_t block_capacity_ = 0;
+    ArenaStats stats_;
+};
@@ -0,0 +1,39 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> allocated_bytes{ 0 };
+
+} // namespace
+
+size_t GetAllocatedBytes() {
+    return allocated_bytes.load(std::memory_order_relaxed);
+}
+
+// Размер блока хранится перед выделенной областью
+void* operator new(size_t size) {
+    void* ptr = std::malloc(size + sizeof(std::max_align_t));
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t*>(ptr) = size;
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    return static_cast<char*>(ptr) + sizeof(std::max_align_t);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+    void* block = static_cast<char*>(ptr) - sizeof(std::max_align_t);
+    allocated_bytes.fetch_sub(*static_cast<size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstddef>
+
+// Байты, занятые через глобальный operator new и еще не освобожденные.
+// Оператор заменяется только в тестах, которые собираются с allocation_counter.cpp
+size_t GetAllocatedBytes();
@@ -0,0 +1,74 @@
+#include "search_server.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <execution>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Сравнение выдачи поиска по битовым массивам статусов и индексу рейтингов с выдачей
+// поиска с равносильным предикатом: после удалений, уплотнения и загрузки снимка,
+// для узких и широких диапазонов рейтингов
+void TestDocumentFilters() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const vector<string> words(dictionary.begin(), dictionary.begin() + 100);
+    SearchServer search_server(""s);
+    search_server.SetThreadPool(make_shared<ThreadPool>(4));
+    const int document_count = 6'000;
+    for (int i = 0; i < document_count; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, words, uniform_int_distribution(1, 30)(generator)),
+            static_cast<DocumentStatus>(uniform_int_distribution(0, 3)(generator)),
+            {uniform_int_distribution(-100, 100)(generator)});
+    }
+    vector<string> queries;
+    for (int i = 0; i < 100; ++i) {
+        queries.push_back(GenerateQuery(generator, words, uniform_int_distribution(1, 10)(generator), 0.1));
+    }
+    const string path = (filesystem::temp_directory_path() / "document_filters_test.snapshot"s).string();
+
+    const auto check = [&](const SearchServer& server) {
+        for (const string& query : queries) {
+            const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, 3)(generator));
+            const int min_rating = uniform_int_distribution(-100, 100)(generator);
+            const int max_rating = min_rating + (uniform_int_distribution(0, 1)(generator) == 0
+                ? uniform_int_distribution(0, 2)(generator) : uniform_int_distribution(0, 150)(generator));
+            const size_t top_count = uniform_int_distribution(1, 20)(generator);
+            const auto expected_status = server.FindTopDocuments(query,
+                [status](int, DocumentStatus document_status, int) { return document_status == status; }, top_count);
+            const auto expected_rating = server.FindTopDocuments(query,
+                [status, min_rating, max_rating](int, DocumentStatus document_status, int rating) {
+                    return document_status == status && rating >= min_rating && rating <= max_rating;
+                }, top_count);
+            ASSERT(IsSameDocuments(server.FindTopDocuments(query, status, top_count), expected_status));
+            ASSERT(IsNearDocuments(server.FindTopDocuments(execution::par, query, status, top_count), expected_status));
+            ASSERT(IsSameDocuments(server.FindTopDocuments(query, status, min_rating, max_rating, top_count),
+                expected_rating));
+            ASSERT(IsNearDocuments(server.FindTopDocuments(execution::par, query, status, min_rating, max_rating, top_count),
+                expected_rating));
+        }
+    };
+    for (const QueryEvaluation evaluation : {QueryEvaluation::EXHAUSTIVE, QueryEvaluation::MAX_SCORE}) {
+        search_server.SetQueryEvaluation(evaluation);
+        check(search_server);
+    }
+    for (int i = 0; i < document_count; i += uniform_int_distribution(1, 4)(generator)) {
+        search_server.RemoveDocument(i);
+    }
+    check(search_server);
+    search_server.Compact();
+    check(search_server);
+    search_server.SaveSnapshot(path);
+    check(SearchServer::LoadSnapshot(path));
+    filesystem::remove(path);
+}
+
+int main() {
+    RUN_TEST(TestDocumentFilters);
+}
@@ -0,0 +1,77 @@
+#include "search_server.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <execution>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Пакетная проверка документов MatchDocuments совпадает с вызовами MatchDocument
+// для каждого документа страницы, в том числе после удалений
+void TestMatchDocuments() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const vector<string> words(dictionary.begin(), dictionary.begin() + 300);
+    SearchServer search_server(""s);
+    const int document_count = 5'000;
+    for (int i = 0; i < document_count; ++i) {
+        // Длинные документы проверяются поиском слов запроса, короткие - слиянием
+        const int word_count = i % 10 == 0 ? 200 : uniform_int_distribution(1, 30)(generator);
+        search_server.AddDocument(i, GenerateQuery(generator, words, word_count),
+            static_cast<DocumentStatus>(uniform_int_distribution(0, 3)(generator)), {1});
+    }
+    for (int i = 0; i < document_count; i += 7) {
+        search_server.RemoveDocument(i);
+    }
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    const int page_size = 20;
+
+    DocumentMatches matches;
+    for (int i = 0; i < 1'000; ++i) {
+        const string query = GenerateQuery(generator, words, uniform_int_distribution(1, 10)(generator), 0.1);
+        vector<int> page(page_size);
+        for (int& document_id : page) {
+            document_id = document_ids[uniform_int_distribution<size_t>(0, document_ids.size() - 1)(generator)];
+        }
+        for (const bool is_parallel : {false, true}) {
+            if (is_parallel) {
+                search_server.MatchDocuments(execution::par, query, page, matches);
+            }
+            else {
+                search_server.MatchDocuments(query, page, matches);
+            }
+            ASSERT_EQUAL(matches.GetDocumentCount(), page.size());
+            for (size_t j = 0; j < page.size(); ++j) {
+                const auto [expected_words, expected_status] = search_server.MatchDocument(query, page[j]);
+                auto actual_words = matches.GetWords(j);
+                ASSERT(equal(expected_words.begin(), expected_words.end(), actual_words.begin(), actual_words.end()));
+                ASSERT(expected_status == matches.GetStatus(j));
+            }
+        }
+    }
+}
+
+// Удаленный документ в пакете приводит к исключению std::out_of_range
+void TestMatchDocumentsMissingId() {
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "dog bird"s, DocumentStatus::BANNED, {1});
+    search_server.RemoveDocument(2);
+    DocumentMatches matches;
+    try {
+        search_server.MatchDocuments("dog"s, {1, 2}, matches);
+        ASSERT_HINT(false, "removed document must be rejected"s);
+    }
+    catch (const out_of_range&) {
+    }
+}
+
+int main() {
+    RUN_TEST(TestMatchDocuments);
+    RUN_TEST(TestMatchDocumentsMissingId);
+}
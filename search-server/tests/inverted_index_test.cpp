@@ -0,0 +1,148 @@
+#include "inverted_index.h"
+#include "string_processing.h"
+
+#include "allocation_counter.h"
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Частоты слов документа так же, как их считает SearchServer::AddDocument
+map<string_view, double> ComputeWordFreqs(string_view document) {
+    map<string_view, double> word_freqs;
+    const auto words = SplitIntoWordsView(document);
+    const double inv_word_count = 1.0 / words.size();
+    for (string_view word : words) {
+        word_freqs[word] += inv_word_count;
+    }
+    return word_freqs;
+}
+
+// Индекс с количеством слов документов, как в SearchServer
+InvertedIndex BuildIndex(const vector<string>& documents) {
+    InvertedIndex index;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        index.SetDocumentWordCount(i, SplitIntoWordsView(documents[i]).size());
+        for (const auto& [word, term_freq] : ComputeWordFreqs(documents[i])) {
+            index.Add(word, i, term_freq);
+        }
+    }
+    return index;
+}
+
+// Непрерывные списки занимают меньше памяти, чем словарь деревьев, и содержат те же пары
+void TestPostingsLayout() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+
+    size_t start_bytes = GetAllocatedBytes();
+    map<string_view, map<int, double>> tree_index;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        for (const auto& [word, term_freq] : ComputeWordFreqs(documents[i])) {
+            tree_index[word][i] = term_freq;
+        }
+    }
+    const size_t tree_bytes = GetAllocatedBytes() - start_bytes;
+
+    start_bytes = GetAllocatedBytes();
+    const InvertedIndex postings_index = BuildIndex(documents);
+    const size_t postings_bytes = GetAllocatedBytes() - start_bytes;
+    ASSERT(postings_bytes < tree_bytes);
+
+    size_t posting_count = 0;
+    for (const auto& [word, document_freqs] : tree_index) {
+        const PostingList* postings = postings_index.Find(word);
+        ASSERT(postings != nullptr);
+        ASSERT_EQUAL(postings->size(), document_freqs.size());
+        size_t i = 0;
+        for (const auto& [ordinal, term_freq] : document_freqs) {
+            ASSERT_EQUAL(postings->ordinals[i], ordinal);
+            ASSERT_EQUAL(postings->term_freqs[i], term_freq);
+            ++i;
+        }
+        posting_count += document_freqs.size();
+    }
+    ASSERT_EQUAL(postings_index.GetPostingCount(), posting_count);
+    ASSERT_EQUAL(postings_index.GetWordCount(), tree_index.size());
+}
+
+// Сжатые списки меньше несжатых и при обходе дают те же номера и частоты
+void TestCompressedPostings() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    InvertedIndex index = BuildIndex(documents);
+
+    const auto collect = [&index] {
+        vector<pair<int, double>> postings;
+        for (const auto& [_, word_postings] : index) {
+            index.ForEachPosting(word_postings, [&postings](int ordinal, double term_freq) {
+                postings.emplace_back(ordinal, term_freq);
+            });
+        }
+        return postings;
+    };
+    const auto raw_postings = collect();
+    const size_t raw_bytes = index.GetMemoryUsage();
+    index.SetPostingsFormat(PostingsFormat::COMPRESSED);
+    ASSERT(index.GetMemoryUsage() < raw_bytes);
+    const auto compressed_postings = collect();
+    ASSERT_EQUAL(compressed_postings.size(), raw_postings.size());
+    for (size_t i = 0; i < raw_postings.size(); ++i) {
+        ASSERT_EQUAL(compressed_postings[i].first, raw_postings[i].first);
+        ASSERT(abs(compressed_postings[i].second - raw_postings[i].second) < 1e-12);
+    }
+    index.SetPostingsFormat(PostingsFormat::RAW);
+    ASSERT(collect() == raw_postings);
+}
+
+// Номер слова не меняется при уплотнении, номера удаленных слов выдаются повторно
+void TestTermIds() {
+    InvertedIndex index;
+    index.Add("cat"sv, 0, 0.5);
+    index.Add("dog"sv, 0, 0.5);
+    index.Add("dog"sv, 1, 1.0);
+    const uint32_t cat_id = index.FindTermId("cat"sv);
+    const uint32_t dog_id = index.FindTermId("dog"sv);
+    ASSERT(cat_id != dog_id);
+    ASSERT_EQUAL(index.FindTermId("bird"sv), NO_TERM_ID);
+    ASSERT_EQUAL(index.GetWord(cat_id), "cat"sv);
+
+    index.Remove("cat"sv, 0);
+    index.EraseWordIfEmpty("cat"sv);
+    ASSERT_EQUAL(index.FindTermId("cat"sv), NO_TERM_ID);
+    index.Compact();
+    ASSERT_EQUAL(index.FindTermId("dog"sv), dog_id);
+    ASSERT_EQUAL(index.GetWord(dog_id), "dog"sv);
+
+    index.Add("bird"sv, 2, 1.0);
+    ASSERT_EQUAL(index.FindTermId("bird"sv), cat_id);
+    ASSERT_EQUAL(index.GetWord(cat_id), "bird"sv);
+
+    // Удаление по номеру, обход пропускает свободные номера
+    index.Remove(dog_id, 0);
+    index.EraseIfEmpty(dog_id);
+    ASSERT_EQUAL(index.Find("dog"sv)->size(), 1u);
+    index.Remove(dog_id, 1);
+    index.EraseIfEmpty(dog_id);
+    ASSERT_EQUAL(index.FindTermId("dog"sv), NO_TERM_ID);
+    vector<string_view> words;
+    for (const auto& [word, postings] : index) {
+        ASSERT_EQUAL(postings.term_id, index.FindTermId(word));
+        words.push_back(word);
+    }
+    ASSERT(words == vector<string_view>{ "bird"sv });
+}
+
+int main() {
+    RUN_TEST(TestPostingsLayout);
+    RUN_TEST(TestCompressedPostings);
+    RUN_TEST(TestTermIds);
+}
@@ -0,0 +1,69 @@
+#include "search_server.h"
+#include "string_processing.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <execution>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Документы выдачи с минус-словами сверяются с прямой проверкой частот слов документов:
+// в выдаче должны быть все документы с плюс-словом и без минус-слов
+void TestMinusWords() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const vector<string> words(dictionary.begin(), dictionary.begin() + 100);
+    SearchServer search_server(""s);
+    const int document_count = 5'000;
+    for (int i = 0; i < document_count; ++i) {
+        search_server.AddDocument(i, GenerateQuery(generator, words, 20), DocumentStatus::ACTUAL, {1});
+    }
+    vector<string> queries;
+    for (int i = 0; i < 100; ++i) {
+        queries.push_back(GenerateQuery(generator, words, 10, 0.3));
+    }
+    for (const PostingsFormat format : {PostingsFormat::RAW, PostingsFormat::COMPRESSED}) {
+        search_server.SetPostingsFormat(format);
+        for (const QueryEvaluation evaluation : {QueryEvaluation::EXHAUSTIVE, QueryEvaluation::MAX_SCORE}) {
+            search_server.SetQueryEvaluation(evaluation);
+            for (const string& query : queries) {
+                set<int> expected;
+                const auto query_words = SplitIntoWordsView(query);
+                for (const int document_id : search_server) {
+                    const auto word_freqs = search_server.GetWordFrequencies(document_id);
+                    bool has_plus_word = false;
+                    bool has_minus_word = false;
+                    for (const string_view word : query_words) {
+                        if (word[0] == '-') {
+                            has_minus_word |= word_freqs.count(word.substr(1)) > 0;
+                        }
+                        else {
+                            has_plus_word |= word_freqs.count(word) > 0;
+                        }
+                    }
+                    if (has_plus_word && !has_minus_word) {
+                        expected.insert(document_id);
+                    }
+                }
+                for (const auto& documents : {search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, document_count),
+                         search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, document_count)}) {
+                    set<int> actual;
+                    for (const Document& document : documents) {
+                        actual.insert(document.id);
+                    }
+                    ASSERT(actual == expected);
+                }
+            }
+        }
+    }
+}
+
+int main() {
+    RUN_TEST(TestMinusWords);
+}
@@ -0,0 +1,138 @@
+#include "process_queries.h"
+#include "search_server.h"
+
+#include "allocation_counter.h"
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+SearchServer MakeServer(mt19937& generator, const vector<string>& dictionary) {
+    SearchServer search_server(dictionary[0]);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    return search_server;
+}
+
+// Потоковая обработка возвращает результаты ProcessQueries в исходном порядке,
+// ProcessQueriesJoined - те же документы подряд
+void TestQueryStreamOrder() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const SearchServer search_server = MakeServer(generator, dictionary);
+    const auto queries = GenerateQueries(generator, dictionary, 2'000, 10);
+    const auto expected = ProcessQueries(search_server, queries);
+    ASSERT_EQUAL(expected.size(), queries.size());
+
+    size_t next_result = 0;
+    size_t next_query = 0;
+    ProcessQueriesStream(search_server,
+        [&](string& query) {
+            if (next_query == queries.size()) {
+                return false;
+            }
+            query = queries[next_query++];
+            return true;
+        },
+        [&](vector<Document> documents) {
+            ASSERT(IsSameDocuments(documents, expected[next_result++]));
+        }, 16);
+    ASSERT_EQUAL(next_result, queries.size());
+
+    string input;
+    for (const string& query : queries) {
+        input += query + '\n';
+    }
+    istringstream input_stream(input);
+    next_result = 0;
+    ProcessQueriesStream(search_server, input_stream, [&](vector<Document> documents) {
+        ASSERT(IsSameDocuments(documents, expected[next_result++]));
+    });
+    ASSERT_EQUAL(next_result, queries.size());
+
+    vector<Document> joined;
+    for (const auto& documents : expected) {
+        joined.insert(joined.end(), documents.begin(), documents.end());
+    }
+    ASSERT(IsSameDocuments(ProcessQueriesJoined(search_server, queries), joined));
+}
+
+// Память потоковой обработки не растет с количеством запросов:
+// пиковый объем меньше, чем у ProcessQueries по вектору тех же запросов
+void TestQueryStreamMemory() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const SearchServer search_server = MakeServer(generator, dictionary);
+    const int query_count = 20'000;
+
+    const size_t base_bytes = GetAllocatedBytes();
+    size_t vector_peak_bytes = 0;
+    {
+        vector<string> queries;
+        queries.reserve(query_count);
+        for (int i = 0; i < query_count; ++i) {
+            queries.push_back(GenerateQuery(generator, dictionary, 10));
+        }
+        const auto documents = ProcessQueries(search_server, queries);
+        vector_peak_bytes = GetAllocatedBytes() - base_bytes;
+    }
+
+    size_t stream_peak_bytes = 0;
+    int next_query = 0;
+    ProcessQueriesStream(search_server,
+        [&](string& query) {
+            if (next_query == query_count) {
+                return false;
+            }
+            query = GenerateQuery(generator, dictionary, 10);
+            ++next_query;
+            return true;
+        },
+        [&](vector<Document>) {
+            stream_peak_bytes = max(stream_peak_bytes, GetAllocatedBytes() - base_bytes);
+        });
+    ASSERT(stream_peak_bytes * 4 < vector_peak_bytes);
+}
+
+// Исключение запроса останавливает обработку, результаты предыдущих запросов переданы
+void TestQueryStreamError() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const SearchServer search_server = MakeServer(generator, dictionary);
+    auto queries = GenerateQueries(generator, dictionary, 100, 10);
+    queries[50] = "--cat"s;
+    size_t next_query = 0;
+    size_t result_count = 0;
+    try {
+        ProcessQueriesStream(search_server,
+            [&](string& query) {
+                if (next_query == queries.size()) {
+                    return false;
+                }
+                query = queries[next_query++];
+                return true;
+            },
+            [&](vector<Document>) {
+                ++result_count;
+            }, 4);
+        ASSERT_HINT(false, "invalid query must be reported"s);
+    }
+    catch (const invalid_argument&) {
+    }
+    ASSERT_EQUAL(result_count, 50u);
+}
+
+int main() {
+    RUN_TEST(TestQueryStreamOrder);
+    RUN_TEST(TestQueryStreamMemory);
+    RUN_TEST(TestQueryStreamError);
+}
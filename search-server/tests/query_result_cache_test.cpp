@@ -0,0 +1,66 @@
+#include "process_queries.h"
+#include "search_server.h"
+#include "string_processing.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Поток запросов с преобладанием популярных: результаты ProcessQueries с кешем
+// совпадают с результатами без кеша, в том числе после изменения индекса
+void TestResultCache() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server(dictionary[0]);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    const auto popular_queries = GenerateQueries(generator, dictionary, 50, 10);
+    vector<string> queries;
+    for (int i = 0; i < 5'000; ++i) {
+        if (uniform_int_distribution(0, 9)(generator) < 9) {
+            // Слова популярных запросов приходят в разном порядке
+            string query = popular_queries[uniform_int_distribution<size_t>(0, popular_queries.size() - 1)(generator)];
+            auto words = SplitIntoWords(query);
+            shuffle(words.begin(), words.end(), generator);
+            query.clear();
+            for (const string& word : words) {
+                query += word + ' ';
+            }
+            queries.push_back(query);
+        }
+        else {
+            queries.push_back(GenerateQuery(generator, dictionary, 10, 0.1));
+        }
+    }
+
+    const auto is_same_results = [](const vector<vector<Document>>& lhs, const vector<vector<Document>>& rhs) {
+        return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), IsSameDocuments);
+    };
+    const auto expected = ProcessQueries(search_server, queries);
+    search_server.SetResultCacheCapacity(1'000);
+    ASSERT(is_same_results(ProcessQueries(search_server, queries), expected));
+    const auto stats = search_server.GetResultCacheStats();
+    ASSERT_EQUAL(stats.hits + stats.misses, queries.size());
+    ASSERT(stats.hits > stats.misses);
+    ASSERT(stats.size <= 1'000 + 16);
+
+    // После изменения индекса кеш не должен возвращать старые результаты
+    const int document_id = *prev(search_server.end()) + 1;
+    search_server.AddDocument(document_id, popular_queries[0], DocumentStatus::ACTUAL, {100});
+    const auto actual = ProcessQueries(search_server, queries);
+    search_server.SetResultCacheCapacity(0);
+    ASSERT(is_same_results(actual, ProcessQueries(search_server, queries)));
+}
+
+int main() {
+    RUN_TEST(TestResultCache);
+}
@@ -0,0 +1,83 @@
+#include "remove_duplicates.h"
+#include "search_server.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <execution>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Сервер с точными копиями, копиями с повтором слов и копиями с одним замененным словом.
+// near_duplicate_ids - id копий с замененным словом
+SearchServer MakeServerWithDuplicates(mt19937& generator, vector<int>& near_duplicate_ids) {
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 2'000, 70);
+    SearchServer search_server(dictionary[0]);
+    const int original_count = static_cast<int>(documents.size());
+    for (int i = 0; i < original_count; ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    for (int i = 0; i + 1 < original_count; i += 10) {
+        search_server.AddDocument(original_count + i, documents[i] + " "s + documents[i], DocumentStatus::ACTUAL, {1});
+        string near_duplicate = documents[i + 1];
+        near_duplicate.replace(0, near_duplicate.find(' '), dictionary[uniform_int_distribution<int>(1, 999)(generator)]);
+        near_duplicate_ids.push_back(2 * original_count + i);
+        search_server.AddDocument(near_duplicate_ids.back(), near_duplicate, DocumentStatus::ACTUAL, {1});
+    }
+    return search_server;
+}
+
+// Поиск точных дубликатов по хешам совпадает с попарным сравнением множеств слов
+void TestExactDuplicates() {
+    mt19937 generator;
+    vector<int> near_duplicate_ids;
+    const SearchServer search_server = MakeServerWithDuplicates(generator, near_duplicate_ids);
+
+    set<int> expected;
+    for (auto it = search_server.begin(); it != search_server.end(); ++it) {
+        const auto words = search_server.GetWordFrequencies(*it);
+        for (auto other = next(it); other != search_server.end(); ++other) {
+            const auto other_words = search_server.GetWordFrequencies(*other);
+            if (equal(words.begin(), words.end(), other_words.begin(), other_words.end(),
+                [](const auto& lhs, const auto& rhs) { return lhs.first == rhs.first; })) {
+                expected.insert(*other);
+            }
+        }
+    }
+    ASSERT(!expected.empty());
+    const vector<int> expected_ids(expected.begin(), expected.end());
+    ASSERT(FindDuplicates(search_server) == expected_ids);
+    ASSERT(FindDuplicates(execution::par, search_server) == expected_ids);
+}
+
+// Почти-дубликаты находятся MinHash/LSH вместе с точными, удаление убирает их из сервера
+void TestNearDuplicates() {
+    mt19937 generator;
+    vector<int> near_duplicate_ids;
+    SearchServer search_server = MakeServerWithDuplicates(generator, near_duplicate_ids);
+    const auto exact = FindDuplicates(search_server);
+    const auto similar = FindDuplicates(search_server, {0.8});
+    ASSERT(similar == FindDuplicates(execution::par, search_server, {0.8}));
+    ASSERT(includes(similar.begin(), similar.end(), exact.begin(), exact.end()));
+    size_t found_count = 0;
+    for (const int document_id : near_duplicate_ids) {
+        found_count += binary_search(similar.begin(), similar.end(), document_id);
+    }
+    // При сходстве около 0.97 LSH находит почти все пары
+    ASSERT(found_count * 10 >= near_duplicate_ids.size() * 9);
+
+    const int document_count = search_server.GetDocumentCount();
+    ASSERT(RemoveDuplicates(execution::par, search_server, {0.8}) == similar);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), document_count - static_cast<int>(similar.size()));
+    ASSERT(FindDuplicates(search_server, {0.8}).empty());
+}
+
+int main() {
+    RUN_TEST(TestExactDuplicates);
+    RUN_TEST(TestNearDuplicates);
+}
@@ -0,0 +1,161 @@
+#include "search_server.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <cstdint>
+#include <cstring>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Сервер из снимка ищет так же, как сохраненный: выдача, MatchDocument,
+// список документов и частоты слов совпадают
+void TestSnapshotRoundTrip() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    SearchServer built_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        built_server.AddDocument(i, documents[i], i % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+            {static_cast<int>(i % 5), 2, 3});
+    }
+    for (size_t i = 0; i < documents.size(); i += 13) {
+        built_server.RemoveDocument(i);
+    }
+
+    const string path = (filesystem::temp_directory_path() / "search_server_test.snapshot"s).string();
+    built_server.SaveSnapshot(path);
+    const SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+    filesystem::remove(path);
+
+    for (const string& query : GenerateQueries(generator, dictionary, 100, 10)) {
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+            ASSERT(IsSameDocuments(loaded_server.FindTopDocuments(query, status), built_server.FindTopDocuments(query, status)));
+        }
+        const int document_id = *loaded_server.begin();
+        ASSERT(built_server.MatchDocument(query, document_id) == loaded_server.MatchDocument(query, document_id));
+    }
+    ASSERT(equal(built_server.begin(), built_server.end(), loaded_server.begin(), loaded_server.end()));
+    for (const int document_id : built_server) {
+        ASSERT(built_server.GetWordFrequencies(document_id) == loaded_server.GetWordFrequencies(document_id));
+    }
+}
+
+// Сервер из снимка, работающий с отображенным файлом, изменяется так же, как сохраненный:
+// добавление документов с новыми словами, удаление документов и уплотнение
+void TestSnapshotModification() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 500, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 2'000, 50);
+    SearchServer built_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size() / 2; ++i) {
+        built_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    const string path = (filesystem::temp_directory_path() / "search_server_modification_test.snapshot"s).string();
+    built_server.SaveSnapshot(path);
+    SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+    filesystem::remove(path);
+
+    const auto check = [&] {
+        for (const string& query : GenerateQueries(generator, dictionary, 50, 5)) {
+            ASSERT(IsSameDocuments(loaded_server.FindTopDocuments(query), built_server.FindTopDocuments(query)));
+        }
+        ASSERT(equal(built_server.begin(), built_server.end(), loaded_server.begin(), loaded_server.end()));
+        for (const int document_id : built_server) {
+            ASSERT(built_server.GetWordFrequencies(document_id) == loaded_server.GetWordFrequencies(document_id));
+        }
+    };
+    check();
+    for (size_t i = 0; i < documents.size() / 2; i += 3) {
+        built_server.RemoveDocument(i);
+        loaded_server.RemoveDocument(execution::par, i);
+    }
+    check();
+    for (size_t i = documents.size() / 2; i < documents.size(); ++i) {
+        const string text = documents[i] + " snapshot_word_"s + to_string(i % 10);
+        built_server.AddDocument(i, text, DocumentStatus::ACTUAL, {1});
+        loaded_server.AddDocument(i, text, DocumentStatus::ACTUAL, {1});
+    }
+    check();
+    loaded_server.Compact();
+    check();
+}
+
+string ReadFile(const string& path) {
+    ifstream input(path, ios::binary);
+    return string(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+}
+
+void WriteFile(const string& path, const string& content) {
+    ofstream output(path, ios::binary | ios::trunc);
+    output.write(content.data(), content.size());
+}
+
+bool IsRejected(const string& path) {
+    try {
+        SearchServer::LoadSnapshot(path);
+    }
+    catch (const runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// Снимок с номерами документов в списках слов вне диапазона номеров или на месте
+// удаленного документа, а также обрезанный снимок не загружаются
+void TestCorruptedSnapshot() {
+    // Каждое слово встречается в одном документе, документ 1 удален
+    SearchServer search_server(""s);
+    search_server.AddDocument(0, "cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(1, "dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "bird"s, DocumentStatus::ACTUAL, {1});
+    search_server.RemoveDocument(1);
+    const string path = (filesystem::temp_directory_path() / "search_server_corrupted_test.snapshot"s).string();
+    search_server.SaveSnapshot(path);
+    const string snapshot = ReadFile(path);
+    ASSERT(!IsRejected(path));
+
+    // Заголовок: сигнатура, версия, порядок байт, затем размеры разделов. Номера документов
+    // списков идут за строками, стоп-словами (по 16 байт), словами (по 24 байта)
+    // и ячейками словаря (по 4 байта, раздел выровнен на 8 байт)
+    uint64_t sizes[8];
+    memcpy(sizes, snapshot.data() + 16, sizeof(sizes));
+    const uint64_t string_bytes = sizes[0];
+    const uint64_t stop_word_count = sizes[1];
+    const uint64_t word_count = sizes[2];
+    const uint64_t dictionary_slot_count = sizes[3];
+    const uint64_t posting_count = sizes[4];
+    ASSERT_EQUAL(word_count, 2u);
+    ASSERT_EQUAL(posting_count, 2u);
+    const size_t postings_offset = (16 + sizeof(sizes) + string_bytes + 7) / 8 * 8
+        + stop_word_count * 16 + word_count * 24 + (dictionary_slot_count * 4 + 7) / 8 * 8;
+
+    for (const int32_t ordinal : {1, 3, -1}) {
+        string corrupted = snapshot;
+        for (uint64_t i = 0; i < posting_count; ++i) {
+            memcpy(corrupted.data() + postings_offset + i * sizeof(int32_t), &ordinal, sizeof(int32_t));
+        }
+        WriteFile(path, corrupted);
+        ASSERT_HINT(IsRejected(path), "posting ordinal "s + to_string(ordinal));
+    }
+    for (const size_t size : {snapshot.size() / 2, snapshot.size() - 8}) {
+        WriteFile(path, snapshot.substr(0, size));
+        ASSERT_HINT(IsRejected(path), "truncated to "s + to_string(size));
+    }
+    filesystem::remove(path);
+}
+
+int main() {
+    RUN_TEST(TestSnapshotRoundTrip);
+    RUN_TEST(TestSnapshotModification);
+    RUN_TEST(TestCorruptedSnapshot);
+}
@@ -0,0 +1,264 @@
+#include "search_server.h"
+
+#include "allocation_counter.h"
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <execution>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+SearchServer MakeServer(const string& stop_words, const vector<string>& documents) {
+    SearchServer search_server(stop_words);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    return search_server;
+}
+
+// Параллельный поиск любым способом накопления релевантности совпадает с последовательным
+void TestParallelAccumulation() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server = MakeServer(dictionary[0], GenerateQueries(generator, dictionary, 3'000, 70));
+    // Задач столько, сколько потоков в пуле, независимо от количества ядер
+    search_server.SetThreadPool(make_shared<ThreadPool>(4));
+    for (const int word_count : {2, 70}) {
+        for (const string& query : GenerateQueries(generator, dictionary, 100, word_count)) {
+            const auto expected = search_server.FindTopDocuments(query);
+            for (const ParallelAccumulation accumulation : {ParallelAccumulation::CONCURRENT_MAP,
+                    ParallelAccumulation::PARTIAL_TABLES, ParallelAccumulation::DOCUMENT_RANGES}) {
+                search_server.SetParallelAccumulation(accumulation);
+                ASSERT(IsNearDocuments(search_server.FindTopDocuments(execution::par, query), expected));
+            }
+        }
+    }
+}
+
+// Пакетное добавление дает те же результаты поиска, что и последовательное,
+// а пакет с повтором id не изменяет сервер
+void TestBatchIndexing() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    const SearchServer sequential_server = MakeServer(dictionary[0], documents);
+
+    vector<NewDocument> new_documents;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        new_documents.push_back({static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+    SearchServer batch_server(dictionary[0]);
+    batch_server.SetThreadPool(make_shared<ThreadPool>(4));
+    batch_server.AddDocuments(execution::par, new_documents);
+    for (const string& query : GenerateQueries(generator, dictionary, 100, 10)) {
+        ASSERT(IsSameDocuments(batch_server.FindTopDocuments(query), sequential_server.FindTopDocuments(query)));
+    }
+    for (const int document_id : sequential_server) {
+        ASSERT(batch_server.GetWordFrequencies(document_id) == sequential_server.GetWordFrequencies(document_id));
+    }
+
+    const vector<NewDocument> duplicate_ids = {
+        {10'000, "cat"sv, DocumentStatus::ACTUAL, {1}}, {10'000, "dog"sv, DocumentStatus::ACTUAL, {1}} };
+    try {
+        batch_server.AddDocuments(duplicate_ids);
+        ASSERT_HINT(false, "duplicate ids must be rejected"s);
+    }
+    catch (const invalid_argument&) {
+    }
+    ASSERT_EQUAL(batch_server.GetDocumentCount(), static_cast<int>(documents.size()));
+}
+
+// Сравнение выдачи полного перебора, MaxScore и параллельного MaxScore по диапазонам документов
+// на случайных серверах и запросах: разные статусы, рейтинги, удаленные документы,
+// минус-слова, размеры выдачи и форматы списков
+void TestMaxScore() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    // Диапазонов столько, сколько потоков в пуле, независимо от количества ядер
+    const auto thread_pool = make_shared<ThreadPool>(4);
+    for (int round = 0; round < 20; ++round) {
+        const int word_count = uniform_int_distribution(5, 200)(generator);
+        const vector<string> words(dictionary.begin(), dictionary.begin() + word_count);
+        SearchServer search_server(GenerateQuery(generator, words, 3));
+        search_server.SetThreadPool(thread_pool);
+        search_server.SetParallelAccumulation(ParallelAccumulation::DOCUMENT_RANGES);
+        const int document_count = uniform_int_distribution(1, 3'000)(generator);
+        for (int i = 0; i < document_count; ++i) {
+            search_server.AddDocument(i, GenerateQuery(generator, words, uniform_int_distribution(1, 40)(generator)),
+                static_cast<DocumentStatus>(uniform_int_distribution(0, 3)(generator)),
+                {uniform_int_distribution(-3, 3)(generator)});
+        }
+        for (int i = 0; i < document_count; i += uniform_int_distribution(1, 20)(generator)) {
+            search_server.RemoveDocument(i);
+        }
+        for (const PostingsFormat format : {PostingsFormat::RAW, PostingsFormat::COMPRESSED}) {
+            search_server.SetPostingsFormat(format);
+            for (int i = 0; i < 50; ++i) {
+                const string query = GenerateQuery(generator, words, uniform_int_distribution(1, 20)(generator), 0.1);
+                const size_t top_count = uniform_int_distribution(0, 20)(generator);
+                const auto find = [&](QueryEvaluation evaluation) {
+                    search_server.SetQueryEvaluation(evaluation);
+                    return pair{search_server.FindTopDocuments(query, DocumentStatus::ACTUAL, top_count),
+                        search_server.FindTopDocuments(query,
+                            [](int document_id, DocumentStatus, int rating) { return document_id % 3 != 0 && rating >= 0; },
+                            top_count)};
+                };
+                const auto expected = find(QueryEvaluation::EXHAUSTIVE);
+                const auto actual = find(QueryEvaluation::MAX_SCORE);
+                ASSERT(IsSameDocuments(actual.first, expected.first));
+                ASSERT(IsSameDocuments(actual.second, expected.second));
+                // Длинные запросы DOCUMENT_RANGES ищет как PARTIAL_TABLES, с другим порядком сложения
+                ASSERT(IsNearDocuments(
+                    search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, top_count), expected.first));
+            }
+        }
+    }
+}
+
+// Поиск по сжатым спискам совпадает с поиском по несжатым, в том числе
+// после удалений и добавления документа в сжатый индекс
+void TestCompressedPostingsSearch() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    SearchServer raw_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        raw_server.AddDocument(i, documents[i], static_cast<DocumentStatus>(i % 2), {static_cast<int>(i)});
+    }
+    for (size_t i = 0; i < documents.size(); i += 11) {
+        raw_server.RemoveDocument(i);
+    }
+    SearchServer compressed_server = raw_server;
+    compressed_server.SetPostingsFormat(PostingsFormat::COMPRESSED);
+    compressed_server.AddDocument(documents.size(), documents[0], DocumentStatus::ACTUAL, {0});
+    raw_server.AddDocument(documents.size(), documents[0], DocumentStatus::ACTUAL, {0});
+
+    for (const string& query : GenerateQueries(generator, dictionary, 100, 10)) {
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT}) {
+            const auto expected = raw_server.FindTopDocuments(query, status);
+            ASSERT(IsSameDocuments(compressed_server.FindTopDocuments(query, status), expected));
+            ASSERT(IsSameDocuments(compressed_server.FindTopDocuments(execution::par, query, status), expected));
+        }
+    }
+}
+
+// При постоянном добавлении и удалении документов мертвых байт не становится больше
+// живых сверх порога автоматического уплотнения
+void TestStorageCompaction() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 5'000, 70);
+    SearchServer search_server(dictionary[0]);
+    const int window_size = 1'000;
+    size_t max_removed_count = 0;
+    for (int i = 0; i < static_cast<int>(documents.size()); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        if (i >= window_size) {
+            search_server.RemoveDocument(i - window_size);
+        }
+        const auto stats = search_server.GetStorageStats();
+        ASSERT(stats.dead_bytes < COMPACTION_MIN_DEAD_BYTES || stats.dead_bytes <= stats.live_bytes);
+        max_removed_count = max(max_removed_count, stats.removed_document_count);
+    }
+    ASSERT(max_removed_count < documents.size() - window_size);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), window_size);
+
+    search_server.Compact();
+    const auto stats = search_server.GetStorageStats();
+    ASSERT_EQUAL(stats.dead_bytes, 0u);
+    ASSERT_EQUAL(stats.removed_document_count, 0u);
+}
+
+// Частоты слов документов из прямого индекса совпадают с посчитанными по тексту,
+// в том числе после удалений и уплотнения, а сервер занимает меньше 64 байт
+// на вхождение слова в документ
+void TestWordFrequencies() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    const size_t start_bytes = GetAllocatedBytes();
+    SearchServer search_server(""s);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1});
+    }
+    const size_t server_bytes = GetAllocatedBytes() - start_bytes;
+
+    const auto check_word_freqs = [&] {
+        size_t posting_count = 0;
+        for (const int document_id : search_server) {
+            map<string_view, double> expected;
+            const auto words = SplitIntoWordsView(documents[document_id]);
+            for (string_view word : words) {
+                expected[word] += 1.0 / words.size();
+            }
+            const WordFrequencies word_freqs = search_server.GetWordFrequencies(document_id);
+            ASSERT(equal(word_freqs.begin(), word_freqs.end(), expected.begin(), expected.end(),
+                [](const auto& lhs, const auto& rhs) {
+                    return lhs.first == rhs.first && abs(lhs.second - rhs.second) < 1e-12;
+                }));
+            ASSERT_EQUAL(word_freqs.count(words[0]), 1u);
+            ASSERT_EQUAL(word_freqs.count("-"sv), 0u);
+            posting_count += word_freqs.size();
+        }
+        return posting_count;
+    };
+    const size_t posting_count = check_word_freqs();
+    ASSERT(server_bytes < 64 * posting_count);
+
+    for (size_t i = 0; i < documents.size(); i += 2) {
+        search_server.RemoveDocument(i);
+        ASSERT(search_server.GetWordFrequencies(i).empty());
+    }
+    check_word_freqs();
+    search_server.Compact();
+    check_word_freqs();
+}
+
+// Последовательное и параллельное удаление документов дают одинаковый индекс:
+// совпадают выдача и частоты слов, слова удаленных документов исчезают из словаря,
+// а их номера выдаются новым словам
+void TestParallelRemove() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    SearchServer sequential_server = MakeServer(dictionary[0], documents);
+    SearchServer parallel_server = MakeServer(dictionary[0], documents);
+    parallel_server.SetThreadPool(make_shared<ThreadPool>(4));
+    for (int i = 0; i < static_cast<int>(documents.size()); i += 3) {
+        sequential_server.RemoveDocument(i);
+        parallel_server.RemoveDocument(execution::par, i);
+    }
+    const int unique_id = static_cast<int>(documents.size());
+    for (SearchServer* search_server : {&sequential_server, &parallel_server}) {
+        search_server->AddDocument(unique_id, "unique"s, DocumentStatus::ACTUAL, {1});
+        search_server->RemoveDocument(execution::par, unique_id);
+        ASSERT(search_server->FindTopDocuments("unique"s).empty());
+        search_server->AddDocument(unique_id, "other"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_EQUAL(search_server->GetWordFrequencies(unique_id).count("other"sv), 1u);
+    }
+
+    ASSERT_EQUAL(parallel_server.GetDocumentCount(), sequential_server.GetDocumentCount());
+    for (const string& query : GenerateQueries(generator, dictionary, 100, 10)) {
+        ASSERT(IsSameDocuments(parallel_server.FindTopDocuments(query), sequential_server.FindTopDocuments(query)));
+    }
+    for (const int document_id : sequential_server) {
+        ASSERT(parallel_server.GetWordFrequencies(document_id) == sequential_server.GetWordFrequencies(document_id));
+    }
+}
+
+int main() {
+    RUN_TEST(TestParallelAccumulation);
+    RUN_TEST(TestBatchIndexing);
+    RUN_TEST(TestMaxScore);
+    RUN_TEST(TestCompressedPostingsSearch);
+    RUN_TEST(TestStorageCompaction);
+    RUN_TEST(TestWordFrequencies);
+    RUN_TEST(TestParallelRemove);
+}
@@ -0,0 +1,101 @@
+#include "search_server.h"
+#include "search_stats.h"
+#include "thread_pool.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <execution>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Пул создается раньше реестра статистики, поэтому его рабочие потоки завершаются
+// уже после уничтожения статических объектов, созданных позже пула
+shared_ptr<ThreadPool> GetStaticThreadPool() {
+    static const auto thread_pool = make_shared<ThreadPool>(4);
+    return thread_pool;
+}
+
+// Рабочие потоки статического пула записывают статистику и завершаются при выходе из программы
+void TestStaticPoolStats() {
+    const shared_ptr<ThreadPool> thread_pool = GetStaticThreadPool();
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server(dictionary[0]);
+    search_server.SetThreadPool(thread_pool);
+    const auto documents = GenerateQueries(generator, dictionary, 1'000, 70);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    for (const string& query : GenerateQueries(generator, dictionary, 100, 10)) {
+        search_server.FindTopDocuments(execution::par, query);
+    }
+    thread_pool->ParallelFor(100, [](size_t) {
+        SearchStageTimer timer(SearchStage::RANKING);
+    });
+}
+
+// Счетчики и гистограммы этапов поиска при полном переборе и MaxScore.
+// Без SEARCH_SERVER_STATS снимок статистики пуст
+void TestSearchStats() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server(dictionary[0]);
+    const auto documents = GenerateQueries(generator, dictionary, 1'000, 70);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 100, 10);
+    const uint64_t expected_count = SearchStats::IS_ENABLED ? queries.size() : 0;
+
+    for (const QueryEvaluation evaluation : {QueryEvaluation::EXHAUSTIVE, QueryEvaluation::MAX_SCORE}) {
+        search_server.SetQueryEvaluation(evaluation);
+        SearchServer::ResetStats();
+        for (const string& query : queries) {
+            search_server.FindTopDocuments(query);
+        }
+        const SearchStatsSnapshot stats = SearchServer::GetStatsSnapshot();
+        ASSERT_EQUAL(stats.GetCounter(SearchCounter::QUERIES), expected_count);
+        ASSERT_EQUAL(stats.GetStage(SearchStage::PARSE_QUERY).GetCount(), expected_count);
+        ASSERT_EQUAL(stats.GetStage(SearchStage::RANKING).GetCount(), expected_count);
+        ASSERT_EQUAL(stats.GetStage(SearchStage::TOKENIZE).GetCount(), 0u);
+        ASSERT_EQUAL(stats.GetCounter(SearchCounter::DOCUMENTS_SCORED) > 0, SearchStats::IS_ENABLED);
+        ASSERT(stats.GetCounter(SearchCounter::DOCUMENTS_SCORED) <= stats.GetCounter(SearchCounter::POSTINGS_SCANNED));
+    }
+}
+
+// Статистика завершенных потоков остается в снимке
+void TestFinishedThreadStats() {
+    SearchServer::ResetStats();
+    const int thread_count = 8;
+    const int timer_count = 100;
+    vector<thread> threads;
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([] {
+            for (int j = 0; j < timer_count; ++j) {
+                SearchStageTimer timer(SearchStage::RANKING);
+                SearchStats::Add(SearchCounter::QUERIES);
+            }
+        });
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    const uint64_t expected_count = SearchStats::IS_ENABLED ? thread_count * timer_count : 0;
+    const SearchStatsSnapshot stats = SearchServer::GetStatsSnapshot();
+    ASSERT_EQUAL(stats.GetStage(SearchStage::RANKING).GetCount(), expected_count);
+    ASSERT_EQUAL(stats.GetCounter(SearchCounter::QUERIES), expected_count);
+    SearchServer::ResetStats();
+    ASSERT_EQUAL(SearchServer::GetStatsSnapshot().GetCounter(SearchCounter::QUERIES), 0u);
+}
+
+int main() {
+    RUN_TEST(TestStaticPoolStats);
+    RUN_TEST(TestSearchStats);
+    RUN_TEST(TestFinishedThreadStats);
+}
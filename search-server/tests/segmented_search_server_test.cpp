@@ -0,0 +1,57 @@
+#include "search_server.h"
+#include "segmented_search_server.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Добавление с удалением старых документов: выдача и MatchDocument сегментированного
+// сервера совпадают с SearchServer при фоновом слиянии и при слиянии в потоке писателя
+void TestSegmentedIndex() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 5'000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 100, 10);
+    const int window_size = 2'000;
+
+    SearchServer search_server(dictionary[0]);
+    for (int i = 0; i < static_cast<int>(documents.size()); ++i) {
+        search_server.AddDocument(i, documents[i], static_cast<DocumentStatus>(i % 2), {i});
+        if (i >= window_size) {
+            search_server.RemoveDocument(i - window_size);
+        }
+    }
+    for (const bool background_merge : {true, false}) {
+        SegmentedSearchServer segmented_server(dictionary[0], {256, 4, background_merge});
+        for (int i = 0; i < static_cast<int>(documents.size()); ++i) {
+            segmented_server.AddDocument(i, documents[i], static_cast<DocumentStatus>(i % 2), {i});
+            if (i >= window_size) {
+                segmented_server.RemoveDocument(i - window_size);
+            }
+        }
+        segmented_server.WaitForMerges();
+        ASSERT_EQUAL(segmented_server.GetDocumentCount(), search_server.GetDocumentCount());
+
+        // Рейтинг документа равен его id, поэтому порядок выдачи однозначен
+        for (const string& query : queries) {
+            for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT}) {
+                ASSERT(IsSameDocuments(segmented_server.FindTopDocuments(query, status),
+                    search_server.FindTopDocuments(query, status)));
+            }
+            const int document_id = *search_server.begin();
+            ASSERT(search_server.MatchDocument(query, document_id) == segmented_server.MatchDocument(query, document_id));
+        }
+        const auto stats = segmented_server.GetSegmentStats();
+        ASSERT(stats.merge_count > 0);
+        ASSERT(stats.segment_count < documents.size() / 256);
+    }
+}
+
+int main() {
+    RUN_TEST(TestSegmentedIndex);
+}
@@ -0,0 +1,67 @@
+#include "string_hash_map.h"
+#include "string_processing.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Потоковое разбиение дает те же слова, что и SplitIntoWordsView,
+// а слова со спецсимволами отмечаются некорректными
+void TestForEachWord() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 20);
+    for (string document : GenerateQueries(generator, dictionary, 1'000, 30)) {
+        document = "  "s + document + "   "s;
+        vector<string_view> words;
+        ForEachWord(document, [&words](string_view word, bool is_valid) {
+            ASSERT(is_valid);
+            words.push_back(word);
+        });
+        ASSERT(words == SplitIntoWordsView(document));
+    }
+
+    vector<pair<string_view, bool>> words;
+    ForEachWord("cat d\x01og  bird\x1f"sv, [&words](string_view word, bool is_valid) {
+        words.emplace_back(word, is_valid);
+    });
+    const vector<pair<string_view, bool>> expected = { {"cat"sv, true}, {"d\x01og"sv, false}, {"bird\x1f"sv, false} };
+    ASSERT(words == expected);
+}
+
+// Отсев стоп-слов хеш-таблицей совпадает с отсевом по std::set
+void TestStopWordHashSet() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 1'000, 70);
+    const vector<string> stop_words(dictionary.begin(), dictionary.begin() + dictionary.size() / 10);
+    const set<string, less<>> stop_word_set(stop_words.begin(), stop_words.end());
+    StringHashSet stop_word_hash_set;
+    for (const string& stop_word : stop_words) {
+        stop_word_hash_set.Insert(stop_word);
+    }
+    ASSERT_EQUAL(stop_word_hash_set.size(), stop_word_set.size());
+
+    for (const string& document : documents) {
+        size_t word_count = 0;
+        for (string_view word : SplitIntoWordsView(document)) {
+            word_count += stop_word_set.count(word) == 0;
+        }
+        size_t hash_word_count = 0;
+        ForEachWord(document, [&](string_view word, bool) {
+            hash_word_count += !stop_word_hash_set.Contains(word);
+        });
+        ASSERT_EQUAL(hash_word_count, word_count);
+    }
+}
+
+int main() {
+    RUN_TEST(TestForEachWord);
+    RUN_TEST(TestStopWordHashSet);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "document.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+// Случайные слова, документы и запросы для тестов и сравнение выдач
+
+inline std::string GenerateWord(std::mt19937& generator, int max_length) {
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+inline std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+// Слова запроса берутся из dictionary, каждое с вероятностью minus_prob становится минус-словом
+inline std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    int word_count, double minus_prob = 0) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+inline std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    int query_count, int max_word_count) {
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+// Выдачи совпадают до бита
+inline bool IsSameDocuments(const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const Document& lhs, const Document& rhs) {
+            return lhs.id == rhs.id && lhs.relevance == rhs.relevance && lhs.rating == rhs.rating;
+        });
+}
+
+// Выдачи совпадают с точностью до погрешности сложения релевантности в другом порядке
+inline bool IsNearDocuments(const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+        [](const Document& lhs, const Document& rhs) {
+            return lhs.id == rhs.id && std::abs(lhs.relevance - rhs.relevance) < 1e-9 && lhs.rating == rhs.rating;
+        });
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Проверки модульных тестов: при нарушении условия выводят место проверки
+// и подсказку и завершают программу, поэтому CTest считает тест непройденным
+
+template <typename T, typename U>
+void AssertEqualImpl(const T& t, const U& u, const std::string& t_str, const std::string& u_str,
+    const std::string& file, const std::string& func, unsigned line, const std::string& hint) {
+    using namespace std::string_literals;
+    if (t != u) {
+        std::cerr << std::boolalpha;
+        std::cerr << file << "("s << line << "): "s << func << ": "s;
+        std::cerr << "ASSERT_EQUAL("s << t_str << ", "s << u_str << ") failed: "s;
+        std::cerr << t << " != "s << u << "."s;
+        if (!hint.empty()) {
+            std::cerr << " Hint: "s << hint;
+        }
+        std::cerr << std::endl;
+        std::abort();
+    }
+}
+
+#define ASSERT_EQUAL(a, b) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, std::string())
+
+#define ASSERT_EQUAL_HINT(a, b, hint) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, (hint))
+
+inline void AssertImpl(bool value, const std::string& expr_str, const std::string& file, const std::string& func,
+    unsigned line, const std::string& hint) {
+    using namespace std::string_literals;
+    if (!value) {
+        std::cerr << file << "("s << line << "): "s << func << ": "s;
+        std::cerr << "ASSERT("s << expr_str << ") failed."s;
+        if (!hint.empty()) {
+            std::cerr << " Hint: "s << hint;
+        }
+        std::cerr << std::endl;
+        std::abort();
+    }
+}
+
+#define ASSERT(expr) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, std::string())
+
+#define ASSERT_HINT(expr, hint) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, (hint))
+
+template <typename TestFunc>
+void RunTestImpl(const TestFunc& func, const std::string& test_name) {
+    func();
+    std::cerr << test_name << " OK" << std::endl;
+}
+
+#define RUN_TEST(func) RunTestImpl((func), #func)
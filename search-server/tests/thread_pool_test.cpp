@@ -0,0 +1,116 @@
+#include "process_queries.h"
+#include "search_server.h"
+#include "thread_pool.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <atomic>
+#include <execution>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ParallelFor вызывает функцию для каждого индекса ровно один раз,
+// в том числе во вложенных вызовах из задач пула
+void TestParallelFor() {
+    for (const size_t thread_count : {1, 2, 4}) {
+        ThreadPool thread_pool(thread_count);
+        vector<atomic<int>> calls(1'000);
+        thread_pool.ParallelFor(calls.size() / 10, [&](size_t i) {
+            thread_pool.ParallelFor(10, [&](size_t j) {
+                ++calls[i * 10 + j];
+            });
+        });
+        for (const auto& call_count : calls) {
+            ASSERT_EQUAL(call_count.load(), 1);
+        }
+    }
+}
+
+// Первое исключение из задач ParallelFor передается вызывающему после завершения остальных
+void TestParallelForException() {
+    ThreadPool thread_pool(4);
+    atomic<int> call_count = 0;
+    try {
+        thread_pool.ParallelFor(100, [&](size_t i) {
+            ++call_count;
+            if (i == 10) {
+                throw runtime_error("task failed"s);
+            }
+        });
+        ASSERT_HINT(false, "exception must be rethrown"s);
+    }
+    catch (const runtime_error&) {
+    }
+    ASSERT(call_count > 0);
+}
+
+// Исключение из задачи Submit сохраняется в группе и передается из Wait,
+// остальные задачи группы выполняются
+void TestSubmitException() {
+    for (const size_t thread_count : {1, 4}) {
+        ThreadPool thread_pool(thread_count);
+        ThreadPool::TaskGroup group;
+        atomic<int> call_count = 0;
+        for (int i = 0; i < 100; ++i) {
+            thread_pool.Submit(group, [&call_count, i] {
+                ++call_count;
+                if (i == 10) {
+                    throw runtime_error("task failed"s);
+                }
+            });
+        }
+        try {
+            thread_pool.Wait(group);
+            ASSERT_HINT(false, "exception must be rethrown"s);
+        }
+        catch (const runtime_error&) {
+        }
+        ASSERT_EQUAL(call_count.load(), 100);
+        ASSERT(group.IsDone());
+    }
+}
+
+// Пакет запросов и вложенный параллелизм - параллельные запросы, каждый из которых
+// ищет параллельно, - дают результаты последовательного поиска при любом числе потоков
+void TestNestedParallelSearch() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    SearchServer search_server(dictionary[0]);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 500, 10);
+    vector<vector<Document>> expected;
+    for (const string& query : queries) {
+        expected.push_back(search_server.FindTopDocuments(query));
+    }
+
+    for (const size_t thread_count : {1, 2, 4}) {
+        search_server.SetThreadPool(make_shared<ThreadPool>(thread_count));
+        const auto documents = ProcessQueries(search_server, queries);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            ASSERT(IsNearDocuments(documents[i], expected[i]));
+        }
+        vector<vector<Document>> nested_documents(queries.size());
+        search_server.GetThreadPool().ParallelFor(queries.size(), [&](size_t i) {
+            nested_documents[i] = search_server.FindTopDocuments(execution::par, queries[i]);
+        });
+        for (size_t i = 0; i < queries.size(); ++i) {
+            ASSERT(IsNearDocuments(nested_documents[i], expected[i]));
+        }
+    }
+}
+
+int main() {
+    RUN_TEST(TestParallelFor);
+    RUN_TEST(TestParallelForException);
+    RUN_TEST(TestSubmitException);
+    RUN_TEST(TestNestedParallelSearch);
+}
@@ -0,0 +1,127 @@
+#include "search_server.h"
+#include "versioned_search_server.h"
+
+#include "test_data.h"
+#include "test_framework.h"
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Одновременное добавление и удаление документов и поиск по поколениям сервера.
+// Писатель меняет сервер пакетами по batch_size документов, поэтому в любом
+// опубликованном поколении количество документов кратно batch_size,
+// а поколения, которые видит читатель, не убывают
+void TestConcurrentGenerations() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 5'000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 100, 10);
+    const int batch_size = 250;
+    const int reader_count = 3;
+    VersionedSearchServer versioned_server(dictionary[0]);
+    atomic<bool> done = false;
+    atomic<size_t> violation_count = 0;
+
+    vector<thread> readers;
+    for (int reader = 0; reader < reader_count; ++reader) {
+        readers.emplace_back([&, reader] {
+            uint64_t last_generation = 0;
+            for (size_t i = reader; !done; i = (i + 1) % queries.size()) {
+                const uint64_t generation = versioned_server.GetGeneration();
+                const auto snapshot = versioned_server.GetSnapshot();
+                violation_count += generation < last_generation || snapshot->GetDocumentCount() % batch_size != 0;
+                last_generation = generation;
+                for (const Document& document : snapshot->FindTopDocuments(queries[i])) {
+                    violation_count += snapshot->GetWordFrequencies(document.id).empty();
+                }
+            }
+        });
+    }
+
+    // Добавляем документы пакетами, после половины корпуса заменяем старые документы новыми
+    const int document_count = static_cast<int>(documents.size()) / batch_size * batch_size;
+    int removed_count = 0;
+    for (int begin = 0; begin < document_count; begin += batch_size) {
+        vector<NewDocument> batch;
+        for (int id = begin; id < begin + batch_size; ++id) {
+            batch.push_back({id, documents[id], DocumentStatus::ACTUAL, {1, 2, 3}});
+        }
+        versioned_server.Update([&](VersionedSearchServer::Writer& writer) {
+            writer.AddDocuments(batch);
+            if (begin >= document_count / 2) {
+                for (int id = removed_count; id < removed_count + batch_size; ++id) {
+                    writer.RemoveDocument(id);
+                }
+            }
+        });
+        if (begin >= document_count / 2) {
+            removed_count += batch_size;
+        }
+    }
+    done = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQUAL(violation_count.load(), 0u);
+    ASSERT_EQUAL(versioned_server.GetGeneration(), static_cast<uint64_t>(document_count / batch_size));
+    ASSERT_EQUAL(versioned_server.GetDocumentCount(), document_count - removed_count);
+}
+
+// Поколения с добавлением и удалением старых документов: выдача и MatchDocument совпадают
+// с SearchServer, а снимок старого поколения не меняется после следующих обновлений
+void TestGenerationsMatchSearchServer() {
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 3'000, 70);
+    const auto queries = GenerateQueries(generator, dictionary, 100, 10);
+    const int window_size = 1'000;
+
+    SearchServer search_server(dictionary[0]);
+    VersionedSearchServer versioned_server(dictionary[0]);
+    VersionedSearchServer::Snapshot old_snapshot;
+    vector<vector<Document>> old_results;
+    for (int i = 0; i < static_cast<int>(documents.size()); ++i) {
+        search_server.AddDocument(i, documents[i], static_cast<DocumentStatus>(i % 2), {i});
+        versioned_server.Update([&](VersionedSearchServer::Writer& writer) {
+            writer.AddDocument(i, documents[i], static_cast<DocumentStatus>(i % 2), {i});
+            if (i >= window_size) {
+                writer.RemoveDocument(i - window_size);
+            }
+        });
+        if (i >= window_size) {
+            search_server.RemoveDocument(i - window_size);
+        }
+        if (i == window_size) {
+            old_snapshot = versioned_server.GetSnapshot();
+            for (const string& query : queries) {
+                old_results.push_back(old_snapshot->FindTopDocuments(query));
+            }
+        }
+    }
+    ASSERT_EQUAL(versioned_server.GetDocumentCount(), search_server.GetDocumentCount());
+    ASSERT_EQUAL(versioned_server.GetGeneration(), documents.size());
+
+    // Рейтинг документа равен его id, поэтому порядок выдачи однозначен
+    for (const string& query : queries) {
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT}) {
+            ASSERT(IsSameDocuments(versioned_server.FindTopDocuments(query, status),
+                search_server.FindTopDocuments(query, status)));
+        }
+        const int document_id = *search_server.begin();
+        ASSERT(search_server.MatchDocument(query, document_id) == versioned_server.MatchDocument(query, document_id));
+    }
+    ASSERT_EQUAL(old_snapshot->GetNumber(), static_cast<uint64_t>(window_size + 1));
+    for (size_t i = 0; i < queries.size(); ++i) {
+        ASSERT(IsSameDocuments(old_snapshot->FindTopDocuments(queries[i]), old_results[i]));
+    }
+}
+
+int main() {
+    RUN_TEST(TestConcurrentGenerations);
+    RUN_TEST(TestGenerationsMatchSearchServer);
+}
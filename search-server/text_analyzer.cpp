@@ -0,0 +1,116 @@
+#include "text_analyzer.h"
+
+#include <algorithm>
+
+using namespace std::string_literals;
+
+bool TextAnalyzer::IsStopWord(std::string_view word) const {
+    return stop_words_.Contains(word);
+}
+
+bool TextAnalyzer::IsValidWord(std::string_view word) {
+    // A valid word must not contain special characters
+    return HasNoControlChars(word);
+}
+
+void TextAnalyzer::SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const {
+    words.clear();
+    ForEachWord(text, [this, &words](std::string_view word, bool is_valid) {
+        if (!is_valid) {
+            throw std::invalid_argument("Word ["s + std::string{word} + "] is invalid"s);
+        }
+        if (!IsStopWord(word)) {
+            words.push_back(word);
+        }
+    });
+}
+
+void TextAnalyzer::ComputeWordFreqs(std::string_view text, std::vector<std::string_view>& words,
+    WordFreqs& word_freqs) const {
+    SplitIntoWordsNoStop(text, words);
+    std::sort(words.begin(), words.end());
+
+    word_freqs.clear();
+    const double inv_word_count = 1.0 / words.size();
+    for (auto word_begin = words.begin(); word_begin != words.end();) {
+        const auto word_end = std::find_if(word_begin, words.end(),
+            [word_begin](std::string_view word) { return word != *word_begin; });
+        word_freqs.emplace_back(*word_begin, (word_end - word_begin) * inv_word_count);
+        word_begin = word_end;
+    }
+}
+
+TextAnalyzer::QueryWord TextAnalyzer::ParseQueryWord(std::string_view text, bool is_valid) const {
+    if (text.empty()) {
+        throw std::invalid_argument("Query word is empty"s);
+    }
+    std::string_view word = text;
+    bool is_minus = false;
+    if (word[0] == '-') {
+        is_minus = true;
+        word = word.substr(1);
+    }
+    // Не обрабатываем пустые слова, а также слова, состоящие из двойного минуса или
+    // имеющие спецсимволы
+    if (word.empty() || word[0] == '-' || !is_valid) {
+        throw std::invalid_argument("Query word ["s + std::string{text} + "] is invalid"s);
+    }
+    return { word, is_minus, IsStopWord(word) };
+}
+
+// Разбивает запрос на плюс- и минус-слова
+// bool remove_duplicates используется для однопоточной версии
+TextAnalyzer::Query TextAnalyzer::ParseQuery(std::string_view text, const bool remove_duplicates) const {
+    Query result;
+    ParseQuery(text, result, remove_duplicates);
+    return result;
+}
+
+void TextAnalyzer::ParseQuery(std::string_view text, Query& result, const bool remove_duplicates) const {
+    result.plus_words.clear();
+    result.minus_words.clear();
+
+    ForEachWord(text, [this, &result](std::string_view word, bool is_valid) {
+        // Если слово некорректное, то будет выброшено исключение
+        auto query_word = ParseQueryWord(word, is_valid);
+
+        if (!query_word.is_stop) {
+            if (query_word.is_minus) {
+                result.minus_words.push_back(query_word.data);
+            }
+            else {
+                result.plus_words.push_back(query_word.data);
+            }
+        }
+    });
+
+    // Сортируем и удаляем дубликаты слов
+    if (remove_duplicates) {
+        std::sort(result.minus_words.begin(), result.minus_words.end());
+        std::sort(result.plus_words.begin(), result.plus_words.end());
+        result.minus_words.erase(std::unique(result.minus_words.begin(), result.minus_words.end()), result.minus_words.end());
+        result.plus_words.erase(std::unique(result.plus_words.begin(), result.plus_words.end()), result.plus_words.end());
+    }
+}
+
+TextAnalyzer::Query& TextAnalyzer::GetThreadQuery() {
+    thread_local Query query;
+    return query;
+}
+
+const StringHashSet& TextAnalyzer::GetStopWords() const {
+    return stop_words_;
+}
+
+bool TextAnalyzer::RestoreStopWords(std::shared_ptr<const char[]> block,
+    const std::vector<std::string_view>& stop_words) {
+    size_t stop_word_bytes = 0;
+    for (std::string_view stop_word : stop_words) {
+        if (!stop_words_.Insert(stop_word)) {
+            return false;
+        }
+        stop_word_bytes += stop_word.size();
+    }
+    stop_word_storage_.Adopt(std::move(block), stop_word_bytes);
+    return true;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "string_processing.h"
+#include "string_hash_map.h"
+#include "term_arena.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Разбор текстов документов и запросов: разбиение на слова, проверка слов,
+// отсев стоп-слов и разделение запроса на плюс- и минус-слова.
+// Общий для всех видов поискового сервера
+class TextAnalyzer {
+public:
+    TextAnalyzer() = default;
+
+    // Выбрасывает std::invalid_argument, если стоп-слово содержит спецсимволы
+    template <typename StringContainer>
+    explicit TextAnalyzer(const StringContainer& stop_words);
+
+    bool IsStopWord(std::string_view word) const;
+
+    static bool IsValidWord(std::string_view word);
+
+    // Заполняет words словами текста, кроме стоп-слов
+    void SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const;
+
+    // Частоты слов документа, отсортированные по словам
+    using WordFreqs = std::vector<std::pair<std::string_view, double>>;
+
+    // Заполняет word_freqs частотами слов текста, words - буфер для разбиения на слова
+    void ComputeWordFreqs(std::string_view text, std::vector<std::string_view>& words, WordFreqs& word_freqs) const;
+
+    struct Query {
+        std::vector<std::string_view> plus_words;
+        std::vector<std::string_view> minus_words;
+    };
+
+    // Разбивает запрос на плюс- и минус-слова.
+    // Выбрасывает std::invalid_argument, если запрос содержит некорректное слово
+    Query ParseQuery(std::string_view text, const bool remove_duplicates = true) const;
+
+    // Разбивает запрос в переданную структуру, переиспользуя ее память
+    void ParseQuery(std::string_view text, Query& result, const bool remove_duplicates = true) const;
+
+    // Структура запроса текущего потока для последовательного поиска
+    static Query& GetThreadQuery();
+
+    // Стоп-слова для сохранения в снимок
+    const StringHashSet& GetStopWords() const;
+
+    // Восстанавливает стоп-слова из снимка: слова лежат в block и используются без копирования.
+    // Возвращает false, если слова повторяются
+    bool RestoreStopWords(std::shared_ptr<const char[]> block, const std::vector<std::string_view>& stop_words);
+
+private:
+    struct QueryWord {
+        std::string_view data;
+        bool is_minus;
+        bool is_stop;
+    };
+
+    // is_valid - признак отсутствия спецсимволов, определенный при разбиении на слова
+    QueryWord ParseQueryWord(std::string_view text, bool is_valid) const;
+
+    // Хранилище строк стоп-слов
+    TermArena stop_word_storage_;
+
+    // Список стоп-слов: хеш-таблица, проверяемая для каждого слова документов и запросов
+    StringHashSet stop_words_;
+};
+
+template <typename StringContainer>
+TextAnalyzer::TextAnalyzer(const StringContainer& stop_words) {
+    // Extract non-empty stop words
+    for (std::string_view stop_word : MakeUniqueNonEmptyStrings(stop_words)) {
+        if (!IsValidWord(stop_word)) {
+            using namespace std::string_literals;
+            throw std::invalid_argument("Some of stop words are invalid"s);
+        }
+        stop_words_.Insert(stop_word_storage_.Store(stop_word));
+    }
+}
@@ -0,0 +1,119 @@
+#include "thread_pool.h"
+
+#include <utility>
+
+namespace {
+
+// Пул и очередь рабочего потока, в котором выполняется код
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_queue = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t worker_count = thread_count - 1;
+    queues_.reserve(worker_count + 1);
+    for (size_t i = 0; i <= worker_count; ++i) {
+        queues_.push_back(std::make_unique<TaskQueue>());
+    }
+    workers_.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this, i] { Work(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard guard(sleep_mutex_);
+        is_stopped_ = true;
+    }
+    task_added_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(TaskGroup& group, std::function<void()> task) {
+    group.Add();
+    Push([&group, task = std::move(task)] {
+        group.Run(task);
+    });
+}
+
+bool ThreadPool::RunPendingTask() {
+    const size_t own_queue = GetCurrentQueue();
+    std::function<void()> task;
+    {
+        // Свои задачи берутся с конца: их данные, скорее всего, еще в кеше
+        TaskQueue& queue = *queues_[own_queue];
+        std::lock_guard guard(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+    }
+    // Чужие задачи перехватываются с начала очередей
+    for (size_t i = 1; !task && i < queues_.size(); ++i) {
+        TaskQueue& queue = *queues_[(own_queue + i) % queues_.size()];
+        std::lock_guard guard(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    --queued_count_;
+    task();
+    return true;
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::GetDefault() {
+    static const auto pool = std::make_shared<ThreadPool>();
+    return pool;
+}
+
+size_t ThreadPool::GetCurrentQueue() const {
+    return current_pool == this ? current_queue : queues_.size() - 1;
+}
+
+void ThreadPool::Push(std::function<void()> task) {
+    ++queued_count_;
+    {
+        TaskQueue& queue = *queues_[GetCurrentQueue()];
+        std::lock_guard guard(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    // Блокировка не дает рабочему потоку уснуть между проверкой очередей и ожиданием
+    {
+        std::lock_guard guard(sleep_mutex_);
+    }
+    task_added_.notify_one();
+}
+
+void ThreadPool::Wait(TaskGroup& group) {
+    while (!group.IsDone() && RunPendingTask()) {
+    }
+    // Оставшиеся задачи группы уже выполняются другими потоками
+    group.WaitDone();
+    group.RethrowIfFailed();
+}
+
+void ThreadPool::Work(size_t queue) {
+    current_pool = this;
+    current_queue = queue;
+    while (true) {
+        if (RunPendingTask()) {
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        task_added_.wait(lock, [this] { return is_stopped_ || queued_count_ > 0; });
+        if (is_stopped_) {
+            return;
+        }
+    }
+}
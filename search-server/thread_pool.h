@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing) для параллельных версий методов сервера.
+// У каждого рабочего потока своя очередь: свои задачи он берет с конца, а простаивая,
+// перехватывает чужие с начала. Задачи из потоков вне пула попадают в общую очередь.
+// Поток, ожидающий завершения своих задач, сам выполняет задачи из очередей, поэтому
+// вложенные параллельные вызовы (параллельные запросы с параллельным поиском)
+// не создают новых потоков и не блокируют рабочие
+class ThreadPool {
+public:
+    // Счетчик незавершенных задач группы и первое исключение из них.
+    // Группа должна жить до возврата из Wait
+    class TaskGroup {
+    public:
+        explicit TaskGroup(size_t task_count = 0)
+            : pending_count_(task_count) {
+        }
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void Add() {
+            pending_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template <typename Task>
+        void Run(Task& task) noexcept {
+            try {
+                task();
+            }
+            catch (...) {
+                std::lock_guard guard(mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+            }
+            // Уведомление под блокировкой: после последней задачи группа может быть сразу уничтожена
+            std::lock_guard guard(mutex_);
+            if (pending_count_.fetch_sub(1, std::memory_order_release) == 1) {
+                done_.notify_all();
+            }
+        }
+
+        bool IsDone() const {
+            return pending_count_.load(std::memory_order_acquire) == 0;
+        }
+
+        // Ждет завершения задач группы, не выполняя задач пула
+        void WaitDone() {
+            std::unique_lock lock(mutex_);
+            done_.wait(lock, [this] { return IsDone(); });
+        }
+
+        void RethrowIfFailed() const {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+        }
+
+    private:
+        std::atomic<size_t> pending_count_;
+        std::mutex mutex_;
+        std::condition_variable done_;
+        std::exception_ptr error_;
+    };
+
+    // thread_count - количество потоков, выполняющих задачи, включая ожидающий их поток:
+    // создается thread_count - 1 рабочих потоков. 0 - по количеству ядер
+    explicit ThreadPool(size_t thread_count = 0);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    size_t GetThreadCount() const {
+        return workers_.size() + 1;
+    }
+
+    // Вызывает func(i) для i из [0, count) и ждет завершения всех вызовов.
+    // Диапазон делится на непрерывные части, по несколько частей на поток.
+    // Первое исключение из func передается вызывающему после завершения остальных частей
+    template <typename Func>
+    void ParallelFor(size_t count, Func func);
+
+    // Ставит задачу группы в очередь и не ждет ее выполнения.
+    // Исключение из задачи сохраняется в группе и передается из Wait
+    void Submit(TaskGroup& group, std::function<void()> task);
+
+    // Выполняет задачи из очередей, пока не завершатся задачи группы, затем передает
+    // первое исключение из них. Если очереди пусты, а задачи группы еще выполняются
+    // другими потоками, ждет их завершения без активного ожидания
+    void Wait(TaskGroup& group);
+
+    // Выполняет в текущем потоке одну задачу из очередей пула.
+    // Возвращает false, если очереди пусты
+    bool RunPendingTask();
+
+    // Общий пул по количеству ядер
+    static std::shared_ptr<ThreadPool> GetDefault();
+
+private:
+    // Частей диапазона ParallelFor на поток: выравнивают загрузку при неравных частях
+    static constexpr size_t TASKS_PER_THREAD = 4;
+
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Очереди рабочих потоков, последняя - общая для потоков вне пула
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+    // Количество задач во всех очередях
+    std::atomic<size_t> queued_count_{ 0 };
+    std::mutex sleep_mutex_;
+    std::condition_variable task_added_;
+    bool is_stopped_ = false;
+
+    // Очередь текущего потока: своя для рабочего потока пула, иначе общая
+    size_t GetCurrentQueue() const;
+
+    void Push(std::function<void()> task);
+
+    void Work(size_t queue);
+};
+
+template <typename Func>
+void ThreadPool::ParallelFor(size_t count, Func func) {
+    const size_t task_count = std::min(count, GetThreadCount() * TASKS_PER_THREAD);
+    const auto run_part = [&func, count, task_count](size_t task) {
+        const size_t end = count * (task + 1) / task_count;
+        for (size_t i = count * task / task_count; i < end; ++i) {
+            func(i);
+        }
+    };
+    if (task_count <= 1 || GetThreadCount() == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    TaskGroup group(task_count);
+    for (size_t task = 1; task < task_count; ++task) {
+        Push([&group, &run_part, task] {
+            auto run = [&run_part, task] { run_part(task); };
+            group.Run(run);
+        });
+    }
+    auto run_first = [&run_part] { run_part(0); };
+    group.Run(run_first);
+    Wait(group);
+}
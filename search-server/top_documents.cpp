@@ -0,0 +1,56 @@
+#include "top_documents.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < std::numeric_limits<double>::epsilon()) {
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+TopDocuments::TopDocuments(size_t top_count)
+    : top_count_(top_count) {
+    heap_.reserve(top_count);
+}
+
+void TopDocuments::Add(const Document& document) {
+    if (heap_.size() < top_count_) {
+        heap_.push_back(document);
+        std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    }
+    else if (top_count_ > 0 && IsMoreRelevant(document, heap_.front())) {
+        // Вытесняем худший из отобранных документов
+        std::pop_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        heap_.back() = document;
+        std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    }
+}
+
+void TopDocuments::Merge(const TopDocuments& other) {
+    for (const Document& document : other.heap_) {
+        Add(document);
+    }
+}
+
+double TopDocuments::GetThreshold() const {
+    if (top_count_ == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (heap_.size() < top_count_) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    // Документ в пределах epsilon от худшего отобранного может обойти его по рейтингу
+    return heap_.front().relevance - std::numeric_limits<double>::epsilon();
+}
+
+std::vector<Document> TopDocuments::Build() const {
+    std::vector<Document> result = heap_;
+    std::sort_heap(result.begin(), result.end(), IsMoreRelevant);
+    return result;
+}
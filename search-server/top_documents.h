@@ -0,0 +1,34 @@
+#pragma once
+#include "document.h"
+
+#include <cstddef>
+#include <vector>
+
+// Возвращает true, если документ lhs должен стоять в выдаче выше документа rhs:
+// по убыванию релевантности, при равной релевантности - по убыванию рейтинга,
+// при равном рейтинге - по возрастанию id, поэтому выдача не зависит от порядка обхода документов
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+// Отбор top_count лучших документов без полной сортировки всех найденных.
+// Хранит не более top_count документов в куче, вершина которой - худший из отобранных
+class TopDocuments {
+public:
+    explicit TopDocuments(size_t top_count);
+
+    // Добавляет документ, если он лучше худшего из уже отобранных
+    void Add(const Document& document);
+
+    // Добавляет документы, отобранные другим экземпляром
+    void Merge(const TopDocuments& other);
+
+    // Документ с релевантностью не выше порога не попадет в выдачу.
+    // Пока отобрано меньше top_count документов, порог - минус бесконечность
+    double GetThreshold() const;
+
+    // Возвращает отобранные документы, отсортированные от лучшего к худшему
+    std::vector<Document> Build() const;
+
+private:
+    size_t top_count_;
+    std::vector<Document> heap_;
+};
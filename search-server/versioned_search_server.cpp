@@ -0,0 +1,235 @@
+#include "versioned_search_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+uint64_t VersionedSearchServer::Generation::GetNumber() const {
+    return number_;
+}
+
+int VersionedSearchServer::Generation::GetDocumentCount() const {
+    return document_count_;
+}
+
+std::vector<Document> VersionedSearchServer::Generation::FindTopDocuments(std::string_view raw_query,
+    DocumentStatus status, size_t top_count) const {
+    return FindTopDocuments(raw_query,
+        [status](int, DocumentStatus document_status, int) {
+            return document_status == status;
+        },
+        top_count);
+}
+
+SearchServer::MyTuple VersionedSearchServer::Generation::MatchDocument(std::string_view raw_query,
+    int document_id) const {
+    TextAnalyzer::Query& query = TextAnalyzer::GetThreadQuery();
+    text_analyzer_->ParseQuery(raw_query, query);
+    const auto location = FindDocument(document_id);
+    if (!location) {
+        throw std::out_of_range("Invalid document id. Document id is doesn't exist"s);
+    }
+    return MatchSegmentDocument(*segments_[location->segment].segment, location->ordinal, query);
+}
+
+std::vector<std::pair<std::string_view, double>> VersionedSearchServer::Generation::GetWordFrequencies(
+    int document_id) const {
+    std::vector<std::pair<std::string_view, double>> word_freqs;
+    const auto location = FindDocument(document_id);
+    if (!location) {
+        return word_freqs;
+    }
+    const IndexSegment& segment = *segments_[location->segment].segment;
+    for (size_t i = segment.word_offsets[location->ordinal]; i < segment.word_offsets[location->ordinal + 1]; ++i) {
+        word_freqs.emplace_back(segment.words[i], segment.term_freqs[i]);
+    }
+    return word_freqs;
+}
+
+std::optional<VersionedSearchServer::Generation::DocumentLocation> VersionedSearchServer::Generation::FindDocument(
+    int document_id) const {
+    for (size_t i = segments_.size(); i-- > 0;) {
+        const auto it = segments_[i].ordinals->find(document_id);
+        if (it != segments_[i].ordinals->end() && !segments_[i].deletions->deleted[it->second]) {
+            return DocumentLocation{ i, it->second };
+        }
+    }
+    return std::nullopt;
+}
+
+double VersionedSearchServer::Generation::ComputeWordInverseDocumentFreq(std::string_view word) const {
+    // Документы со словом считаются по спискам сегментов за вычетом удаленных
+    size_t document_count = 0;
+    for (const SegmentState& state : segments_) {
+        const PostingList* postings = state.segment->index.Find(word);
+        if (postings == nullptr) {
+            continue;
+        }
+        document_count += postings->size();
+        if (postings->term_id < state.deletions->term_counts.size()) {
+            document_count -= state.deletions->term_counts[postings->term_id];
+        }
+    }
+    if (document_count == 0) {
+        return 0.0;
+    }
+    return std::log(document_count_) - std::log(document_count);
+}
+
+VersionedSearchServer::Writer::Writer(const Generation& current)
+    : next_(current)
+    , own_deletions_(current.segments_.size(), nullptr) {
+}
+
+void VersionedSearchServer::Writer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings) {
+    if (document_id < 0) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+    if (next_.FindDocument(document_id)) {
+        throw std::invalid_argument("Invalid document_id. ID already exists"s);
+    }
+    thread_local std::vector<std::string_view> words;
+    thread_local TextAnalyzer::WordFreqs word_freqs;
+    next_.text_analyzer_->ComputeWordFreqs(document, words, word_freqs);
+
+    if (buffer_ == nullptr) {
+        auto buffer = std::make_shared<IndexSegment>();
+        auto buffer_ordinals = std::make_shared<std::unordered_map<int, int>>();
+        auto deletions = std::make_shared<Generation::Deletions>();
+        buffer_ = buffer.get();
+        buffer_ordinals_ = buffer_ordinals.get();
+        own_deletions_.push_back(deletions.get());
+        next_.segments_.push_back({ std::move(buffer), std::move(buffer_ordinals), std::move(deletions), 0, 0 });
+    }
+    const int ordinal = static_cast<int>(buffer_->GetDocumentCount());
+    buffer_->AddDocument(document_id, SearchServer::ComputeAverageRating(ratings), status, word_freqs);
+    buffer_ordinals_->emplace(document_id, ordinal);
+    own_deletions_.back()->deleted.push_back(false);
+    ++next_.document_count_;
+}
+
+void VersionedSearchServer::Writer::AddDocuments(const std::vector<NewDocument>& documents) {
+    for (const NewDocument& document : documents) {
+        AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+}
+
+void VersionedSearchServer::Writer::RemoveDocument(int document_id) {
+    const auto location = next_.FindDocument(document_id);
+    if (!location) {
+        throw std::invalid_argument("Invalid ID. ID is doesn't exist"s);
+    }
+    // Документ остается в сегменте до слияния, отмечается только удаление
+    Generation::SegmentState& state = next_.segments_[location->segment];
+    Generation::Deletions& deletions = GetOwnDeletions(location->segment);
+    const IndexSegment& segment = *state.segment;
+    // Буфер мог получить новые слова после предыдущего удаления из него
+    if (deletions.term_counts.size() < segment.index.GetWordCount()) {
+        deletions.term_counts.resize(segment.index.GetWordCount(), 0);
+    }
+    deletions.deleted[location->ordinal] = true;
+    for (size_t i = segment.word_offsets[location->ordinal]; i < segment.word_offsets[location->ordinal + 1]; ++i) {
+        ++deletions.term_counts[segment.index.FindTermId(segment.words[i])];
+    }
+    ++state.deleted_count;
+    --next_.document_count_;
+}
+
+VersionedSearchServer::Snapshot VersionedSearchServer::Writer::Finish() {
+    std::vector<Generation::SegmentState>& segments = next_.segments_;
+    while (true) {
+        const auto [first, last] = FindSegmentMergeRange(segments, MERGE_FACTOR);
+        if (first == last) {
+            break;
+        }
+        std::vector<const IndexSegment*> sources;
+        std::vector<const std::vector<bool>*> deleted;
+        size_t level = 0;
+        for (size_t i = first; i < last; ++i) {
+            sources.push_back(segments[i].segment.get());
+            deleted.push_back(&segments[i].deletions->deleted);
+            level = std::max(level, segments[i].level);
+        }
+        SegmentMerge merge = MergeIndexSegments(sources, deleted);
+        const size_t document_count = merge.merged->GetDocumentCount();
+        auto ordinals = std::make_shared<std::unordered_map<int, int>>();
+        ordinals->reserve(document_count);
+        for (size_t ordinal = 0; ordinal < document_count; ++ordinal) {
+            ordinals->emplace(merge.merged->document_ids[ordinal], static_cast<int>(ordinal));
+        }
+        auto deletions = std::make_shared<Generation::Deletions>();
+        deletions->deleted.assign(document_count, false);
+
+        segments.erase(segments.begin() + first, segments.begin() + last);
+        own_deletions_.erase(own_deletions_.begin() + first, own_deletions_.begin() + last);
+        if (document_count > 0) {
+            segments.insert(segments.begin() + first, { std::move(merge.merged), std::move(ordinals),
+                std::move(deletions), 0, last - first > 1 ? level + 1 : level });
+            own_deletions_.insert(own_deletions_.begin() + first, nullptr);
+        }
+    }
+    ++next_.number_;
+    return std::make_shared<const Generation>(std::move(next_));
+}
+
+VersionedSearchServer::Generation::Deletions& VersionedSearchServer::Writer::GetOwnDeletions(size_t segment) {
+    if (own_deletions_[segment] == nullptr) {
+        auto deletions = std::make_shared<Generation::Deletions>(*next_.segments_[segment].deletions);
+        own_deletions_[segment] = deletions.get();
+        next_.segments_[segment].deletions = std::move(deletions);
+    }
+    return *own_deletions_[segment];
+}
+
+VersionedSearchServer::VersionedSearchServer(std::string_view stop_words_text)
+    : VersionedSearchServer(std::make_shared<const TextAnalyzer>(SplitIntoWordsView(stop_words_text))) {
+}
+
+VersionedSearchServer::VersionedSearchServer(std::shared_ptr<const TextAnalyzer> text_analyzer) {
+    Generation generation;
+    generation.text_analyzer_ = std::move(text_analyzer);
+    current_ = std::make_shared<const Generation>(std::move(generation));
+}
+
+VersionedSearchServer::Snapshot VersionedSearchServer::GetSnapshot() const {
+    return std::atomic_load(&current_);
+}
+
+uint64_t VersionedSearchServer::GetGeneration() const {
+    return GetSnapshot()->GetNumber();
+}
+
+void VersionedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings) {
+    Update([&](Writer& writer) {
+        writer.AddDocument(document_id, document, status, ratings);
+    });
+}
+
+void VersionedSearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    Update([&documents](Writer& writer) {
+        writer.AddDocuments(documents);
+    });
+}
+
+void VersionedSearchServer::RemoveDocument(int document_id) {
+    Update([document_id](Writer& writer) {
+        writer.RemoveDocument(document_id);
+    });
+}
+
+SearchServer::MyTuple VersionedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    return GetSnapshot()->MatchDocument(raw_query, document_id);
+}
+
+int VersionedSearchServer::GetDocumentCount() const {
+    return GetSnapshot()->GetDocumentCount();
+}
+
+void VersionedSearchServer::Publish(Snapshot snapshot) {
+    std::atomic_store(&current_, std::move(snapshot));
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include "document.h"
+#include "index_segment.h"
+#include "search_server.h"
+#include "text_analyzer.h"
+#include "top_documents.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Поисковый сервер с неизменяемыми поколениями индекса (RCU).
+// Читатели получают снимок текущего поколения и выполняют запросы к нему без
+// блокировок, пока писатели готовят следующее поколение, и атомарно его публикуют.
+// Поколение - список неизменяемых сегментов (IndexSegment) с отметками удаленных
+// документов. Следующее поколение разделяет с текущим все сегменты: добавленные
+// документы образуют новый сегмент, а удаление копирует только отметки своего сегмента.
+// Как в SegmentedSearchServer, по merge_factor сегментов одного уровня сливаются в один.
+// Старые сегменты освобождаются, когда их отпускает последнее поколение
+class VersionedSearchServer {
+public:
+    // Количество сегментов одного уровня, которые сливаются в один при публикации
+    static constexpr size_t MERGE_FACTOR = 4;
+
+    // Поколение индекса. Не изменяется после публикации
+    class Generation {
+    public:
+        // Номер поколения: 0 у пустого сервера, увеличивается при каждой публикации
+        uint64_t GetNumber() const;
+
+        int GetDocumentCount() const;
+
+        template <typename DocumentPredicate>
+        std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+            size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL,
+            size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+        SearchServer::MyTuple MatchDocument(std::string_view raw_query, int document_id) const;
+
+        // Слова документа с частотами по алфавиту, пустой список для отсутствующего документа.
+        // Слова действительны, пока жив снимок поколения
+        std::vector<std::pair<std::string_view, double>> GetWordFrequencies(int document_id) const;
+
+    private:
+        friend class VersionedSearchServer;
+
+        // Отметки удаленных документов сегмента и количество удаленных документов
+        // с каждым словом сегмента по номерам слов (у слов за концом вектора удалений нет)
+        struct Deletions {
+            std::vector<bool> deleted;
+            std::vector<uint32_t> term_counts;
+        };
+
+        // Сегмент поколения. Сегмент, номера его документов по id и отметки удалений
+        // разделяются поколениями; удаление документа заменяет отметки копией
+        struct SegmentState {
+            std::shared_ptr<const IndexSegment> segment;
+            std::shared_ptr<const std::unordered_map<int, int>> ordinals;
+            std::shared_ptr<const Deletions> deletions;
+            size_t deleted_count = 0;
+            size_t level = 0;
+        };
+
+        // Расположение документа: индекс сегмента в segments_ и порядковый номер в нем
+        struct DocumentLocation {
+            size_t segment;
+            int ordinal;
+        };
+
+        std::shared_ptr<const TextAnalyzer> text_analyzer_;
+        std::vector<SegmentState> segments_;
+        int document_count_ = 0;
+        uint64_t number_ = 0;
+
+        // Неудаленный документ с id document_id или std::nullopt
+        std::optional<DocumentLocation> FindDocument(int document_id) const;
+
+        // IDF слова по неудаленным документам всех сегментов, 0 для отсутствующих слов
+        double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    };
+
+    using Snapshot = std::shared_ptr<const Generation>;
+
+    // Изменения следующего поколения, собираемые в Update. Поколение становится
+    // видимым читателям целиком после завершения Update
+    class Writer {
+    public:
+        void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+            const std::vector<int>& ratings);
+
+        void AddDocuments(const std::vector<NewDocument>& documents);
+
+        void RemoveDocument(int document_id);
+
+    private:
+        friend class VersionedSearchServer;
+
+        explicit Writer(const Generation& current);
+
+        // Сливает сегменты и возвращает поколение со следующим номером
+        Snapshot Finish();
+
+        // Отметки удалений сегмента, принадлежащие только следующему поколению
+        Generation::Deletions& GetOwnDeletions(size_t segment);
+
+        Generation next_;
+        // Сегмент добавленных документов, создается при первом добавлении
+        IndexSegment* buffer_ = nullptr;
+        std::unordered_map<int, int>* buffer_ordinals_ = nullptr;
+        // Копии отметок, сделанные для следующего поколения, по индексам сегментов
+        std::vector<Generation::Deletions*> own_deletions_;
+    };
+
+    template <typename StringContainer>
+    explicit VersionedSearchServer(const StringContainer& stop_words);
+
+    explicit VersionedSearchServer(std::string_view stop_words_text);
+
+    // Текущее поколение. Снимок не изменяется и остается действительным,
+    // пока на него есть ссылка
+    Snapshot GetSnapshot() const;
+
+    // Номер текущего поколения, читается из опубликованного поколения
+    uint64_t GetGeneration() const;
+
+    // Применяет modifier(Writer&) к следующему поколению и публикует его.
+    // Если modifier выбрасывает исключение, поколение не меняется
+    template <typename Modifier>
+    void Update(Modifier modifier);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void AddDocuments(const std::vector<NewDocument>& documents);
+
+    void RemoveDocument(int document_id);
+
+    // Запросы выполняются над текущим поколением
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(Args&&... args) const;
+
+    SearchServer::MyTuple MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+
+private:
+    explicit VersionedSearchServer(std::shared_ptr<const TextAnalyzer> text_analyzer);
+
+    void Publish(Snapshot snapshot);
+
+    // Публикуемое поколение: читается и заменяется атомарными операциями над shared_ptr
+    Snapshot current_;
+
+    // Писатели готовят поколения по очереди
+    std::mutex write_mutex_;
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> VersionedSearchServer::Generation::FindTopDocuments(std::string_view raw_query,
+    DocumentPredicate document_predicate, size_t top_count) const {
+    TextAnalyzer::Query& query = TextAnalyzer::GetThreadQuery();
+    text_analyzer_->ParseQuery(raw_query, query);
+
+    std::vector<double> inverse_document_freqs(query.plus_words.size());
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        inverse_document_freqs[i] = ComputeWordInverseDocumentFreq(query.plus_words[i]);
+    }
+
+    // Документы всех сегментов отбираются в общий набор лучших документов
+    TopDocuments top_documents(top_count);
+    for (const SegmentState& state : segments_) {
+        AddSegmentDocuments(*state.segment, state.deletions->deleted, query, inverse_document_freqs,
+            document_predicate, top_documents);
+    }
+    return top_documents.Build();
+}
+
+template <typename StringContainer>
+VersionedSearchServer::VersionedSearchServer(const StringContainer& stop_words)
+    : VersionedSearchServer(std::make_shared<const TextAnalyzer>(stop_words)) {
+}
+
+template <typename Modifier>
+void VersionedSearchServer::Update(Modifier modifier) {
+    std::lock_guard guard(write_mutex_);
+    Writer writer(*GetSnapshot());
+    modifier(writer);
+    Publish(writer.Finish());
+}
+
+template <typename... Args>
+std::vector<Document> VersionedSearchServer::FindTopDocuments(Args&&... args) const {
+    return GetSnapshot()->FindTopDocuments(std::forward<Args>(args)...);
+}